@@ -0,0 +1,118 @@
+/**
+ *  @note This file is part of MABE, https://github.com/mercere99/MABE2
+ *  @copyright Copyright (C) Michigan State University, MIT Software license; see doc/LICENSE.md
+ *  @date 2021.
+ *
+ *  @file  BenchAvidaGP.cpp
+ *  @brief Compare instructions per second for emp::AvidaGP and CompiledAvidaGP.
+ *
+ *  Usage: BenchAvidaGP [genome_length=100] [num_genomes=1000] [eval_time=500]
+ *
+ *  Random genomes are run on the same inputs through both interpreters (and through the
+ *  compiled one again with introns stripped); outputs are compared to make sure all three
+ *  agree.
+ */
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "emp/hardware/AvidaGP.hpp"
+#include "emp/math/Random.hpp"
+
+#include "../source/tools/CompiledAvidaGP.hpp"
+
+struct BenchInst {
+  size_t id;
+  size_t args[3];
+};
+
+int main(int argc, char* argv[])
+{
+  const size_t genome_length = (argc > 1) ? std::stoul(argv[1]) : 100;
+  const size_t num_genomes = (argc > 2) ? std::stoul(argv[2]) : 1000;
+  const size_t eval_time = (argc > 3) ? std::stoul(argv[3]) : 500;
+  constexpr size_t NUM_OUTPUTS = 8;
+
+  emp::Random random(1);
+  const auto & inst_lib = *emp::AvidaGP().GetInstLib();
+  const emp::vector<double> inputs = { 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0 };
+
+  emp::vector<emp::vector<BenchInst>> genomes(num_genomes);
+  for (auto & genome : genomes) {
+    genome.resize(genome_length);
+    for (BenchInst & inst : genome) {
+      inst.id = random.GetUInt(inst_lib.GetSize());
+      for (size_t & arg : inst.args) arg = random.GetUInt(mabe::CompiledAvidaGP::CPU_SIZE);
+    }
+  }
+
+  using clock_t = std::chrono::steady_clock;
+  auto seconds_since = [](clock_t::time_point start) {
+    return std::chrono::duration<double>(clock_t::now() - start).count();
+  };
+  const double total_insts = (double) (num_genomes * eval_time);
+
+  // Standard hardware.
+  emp::vector<double> results_std(num_genomes * NUM_OUTPUTS);
+  emp::AvidaGP hw;
+  auto start = clock_t::now();
+  for (size_t g = 0; g < num_genomes; ++g) {
+    hw.Reset();
+    for (const BenchInst & inst : genomes[g]) {
+      hw.PushInst(inst.id, inst.args[0], inst.args[1], inst.args[2]);
+    }
+    hw.SetInputs(inputs);
+    hw.Process(eval_time);
+    for (size_t i = 0; i < NUM_OUTPUTS; ++i) {
+      results_std[g*NUM_OUTPUTS + i] = hw.GetOutput((int) i);
+    }
+  }
+  const double time_std = seconds_since(start);
+
+  // Pre-decoded interpreter (compile time included), with and without intron stripping.
+  auto RunCompiled = [&](bool strip_introns, emp::vector<double> & results, size_t & num_failed) {
+    const mabe::CompiledAvidaGP::OpMap op_map(inst_lib);
+    mabe::CompiledAvidaGP program;
+    mabe::CompiledAvidaGP::State state;
+    results.resize(num_genomes * NUM_OUTPUTS);
+    num_failed = 0;
+    auto start = clock_t::now();
+    for (size_t g = 0; g < num_genomes; ++g) {
+      if (!program.Compile(genomes[g], op_map, strip_introns)) {
+        ++num_failed;
+        continue;
+      }
+      program.Run(state, inputs, eval_time);
+      for (size_t i = 0; i < NUM_OUTPUTS; ++i) {
+        results[g*NUM_OUTPUTS + i] = state.GetOutput((int) i);
+      }
+    }
+    return seconds_since(start);
+  };
+
+  emp::vector<double> results_fast, results_strip;
+  size_t failed_fast = 0, failed_strip = 0;
+  const double time_fast = RunCompiled(false, results_fast, failed_fast);
+  const double time_strip = RunCompiled(true, results_strip, failed_strip);
+
+  auto CountMismatches = [&](const emp::vector<double> & results) {
+    size_t count = 0;
+    for (size_t i = 0; i < results.size(); ++i) {
+      // NaN outputs compare unequal to themselves; treat matching NaNs as equal.
+      const bool both_nan = results[i] != results[i] && results_std[i] != results_std[i];
+      if (!both_nan && results[i] != results_std[i]) ++count;
+    }
+    return count;
+  };
+
+  std::cout << num_genomes << " genomes of " << genome_length << " instructions, "
+            << eval_time << " cycles each.\n";
+  std::cout << "emp::AvidaGP:            " << total_insts / time_std / 1e6 << " M inst/sec\n";
+  std::cout << "CompiledAvidaGP:         " << total_insts / time_fast / 1e6 << " M inst/sec  ("
+            << CountMismatches(results_fast) << " output mismatches, "
+            << failed_fast << " not compiled)\n";
+  std::cout << "CompiledAvidaGP (strip): " << total_insts / time_strip / 1e6 << " M inst/sec  ("
+            << CountMismatches(results_strip) << " output mismatches, "
+            << failed_strip << " not compiled)\n";
+}
@@ -0,0 +1,158 @@
+/**
+ *  @note This file is part of MABE, https://github.com/mercere99/MABE2
+ *  @copyright Copyright (C) Michigan State University, MIT Software license; see doc/LICENSE.md
+ *  @date 2021.
+ *
+ *  @file  BenchDiagnostics.cpp
+ *  @brief Time the diagnostic scoring kernels (see tools/Diagnostics.hpp) against the original
+ *         per-organism loops from EvalDiagnostic.
+ *
+ *  Usage: BenchDiagnostics [num_orgs=10000] [num_vals=1000] [reps=5]
+ *
+ *  For each diagnostic, all organisms are scored with the original loops, with the kernels on
+ *  each organism's own vectors (as EvalDiagnostic does), and with ScoreDiagnosticBatch() on one
+ *  matrix.  Scores must match exactly; totals may differ in the last few bits.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+#include "emp/base/vector.hpp"
+#include "emp/math/Random.hpp"
+#include "emp/tools/string_utils.hpp"
+
+#include "../source/tools/Diagnostics.hpp"
+
+using bench_clock_t = std::chrono::steady_clock;
+using namespace mabe;
+
+/// Position of the first maximum value.
+size_t FindMaxIndex(const emp::vector<double> & vals) {
+  size_t pos = 0;
+  for (size_t i = 1; i < vals.size(); i++) if (vals[i] > vals[pos]) pos = i;
+  return pos;
+}
+
+/// The scoring loops from EvalDiagnostic before they were moved into kernels.
+double OriginalScore(DiagnosticType type, const emp::vector<double> & vals,
+                     emp::vector<double> & scores) {
+  scores.resize(vals.size());
+  double total_score = 0.0;
+  size_t pos = 0;
+  switch (type) {
+  case DIAG_EXPLOIT:
+    scores = vals;
+    for (double x : scores) total_score += x;
+    break;
+  case DIAG_STRUCT_EXPLOIT:
+    total_score = scores[0] = vals[0];
+    for (pos = 1; pos < vals.size() && vals[pos] <= vals[pos-1]; ++pos) {
+      total_score += (scores[pos] = vals[pos]);
+    }
+    while (pos < scores.size()) { scores[pos] = 0.0; ++pos; }
+    break;
+  case DIAG_EXPLORE:
+    pos = FindMaxIndex(vals);
+    for (size_t i = 0; i < pos; i++) scores[i] = 0.0;
+    total_score = scores[pos] = vals[pos];
+    pos++;
+    while (pos < vals.size() && vals[pos] <= vals[pos-1]) {
+      total_score += (scores[pos] = vals[pos]);
+      pos++;
+    }
+    while (pos < scores.size()) { scores[pos] = 0.0; ++pos; }
+    break;
+  case DIAG_DIVERSITY:
+    pos = FindMaxIndex(vals);
+    total_score = scores[pos] = vals[pos];
+    for (size_t i = 0; i < vals.size(); i++) {
+      if (i != pos) total_score += (scores[i] = (vals[pos] - vals[i]) / 2.0);
+    }
+    break;
+  case DIAG_WEAK_DIVERSITY:
+    pos = FindMaxIndex(vals);
+    total_score = scores[pos] = vals[pos];
+    for (size_t i = 0; i < vals.size(); i++) {
+      if (i != pos) scores[i] = 0.0;
+    }
+    break;
+  }
+  return total_score;
+}
+
+int main(int argc, char* argv[])
+{
+  const size_t num_orgs = (argc > 1) ? std::stoul(argv[1]) : 10000;
+  const size_t num_vals = (argc > 2) ? std::stoul(argv[2]) : 1000;
+  const size_t reps = (argc > 3) ? std::stoul(argv[3]) : 5;
+  emp::Random random(1);
+
+  // Each organism has its own values and scores vectors, as in the DataMap.
+  emp::vector<emp::vector<double>> org_vals(num_orgs, emp::vector<double>(num_vals));
+  emp::vector<emp::vector<double>> org_scores(num_orgs, emp::vector<double>(num_vals));
+  emp::vector<double> matrix_vals(num_orgs * num_vals), matrix_scores(num_orgs * num_vals);
+  for (size_t org = 0; org < num_orgs; ++org) {
+    for (size_t i = 0; i < num_vals; ++i) {
+      org_vals[org][i] = matrix_vals[org * num_vals + i] = random.GetDouble(0.0, 100.0);
+    }
+  }
+  emp::vector<emp::vector<double>> ref_scores(num_orgs);
+  emp::vector<double> ref_totals(num_orgs), totals(num_orgs);
+
+  // Time fun() over reps; report the average milliseconds per pass over all organisms.
+  auto Time = [reps](auto && fun) {
+    const auto start = bench_clock_t::now();
+    for (size_t rep = 0; rep < reps; ++rep) fun();
+    return std::chrono::duration<double>(bench_clock_t::now() - start).count() * 1000 / reps;
+  };
+
+  // Compare scores (exactly) and totals (relatively) against the original loops.
+  auto Check = [&](auto && get_score) {
+    size_t score_mismatches = 0;
+    double max_rel_diff = 0.0;
+    for (size_t org = 0; org < num_orgs; ++org) {
+      for (size_t i = 0; i < num_vals; ++i) {
+        if (get_score(org, i) != ref_scores[org][i]) ++score_mismatches;
+      }
+      const double diff = std::abs(totals[org] - ref_totals[org]);
+      if (ref_totals[org] != 0.0) max_rel_diff = std::max(max_rel_diff, diff / ref_totals[org]);
+    }
+    return emp::to_string(score_mismatches, " score mismatches, max total diff ", max_rel_diff);
+  };
+
+  std::cout << num_orgs << " organisms x " << num_vals << " values; " << reps << " reps.\n";
+  const std::string names[] = { "exploit", "struct_exploit", "explore", "diversity",
+                                "weak_diversity" };
+  for (size_t type_id = 0; type_id < 5; ++type_id) {
+    const DiagnosticType type = (DiagnosticType) type_id;
+
+    const double original_ms = Time([&](){
+      for (size_t org = 0; org < num_orgs; ++org) {
+        ref_totals[org] = OriginalScore(type, org_vals[org], ref_scores[org]);
+      }
+    });
+
+    const double kernel_ms = Time([&](){
+      for (size_t org = 0; org < num_orgs; ++org) {
+        totals[org] = ScoreDiagnostic(type, org_vals[org].data(), org_scores[org].data(),
+                                      num_vals);
+      }
+    });
+    const std::string kernel_check =
+      Check([&](size_t org, size_t i){ return org_scores[org][i]; });
+
+    const double batch_ms = Time([&](){
+      ScoreDiagnosticBatch(type, matrix_vals.data(), matrix_scores.data(), totals.data(),
+                           num_orgs, num_vals);
+    });
+    const std::string batch_check =
+      Check([&](size_t org, size_t i){ return matrix_scores[org * num_vals + i]; });
+
+    std::cout << names[type_id] << ":\n"
+              << "  original loops: " << original_ms << " ms\n"
+              << "  kernels:        " << kernel_ms << " ms  (" << kernel_check << ")\n"
+              << "  batch:          " << batch_ms << " ms  (" << batch_check << ")\n";
+  }
+}
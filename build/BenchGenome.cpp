@@ -0,0 +1,112 @@
+/**
+ *  @note This file is part of MABE, https://github.com/mercere99/MABE2
+ *  @copyright Copyright (C) Michigan State University, MIT Software license; see doc/LICENSE.md
+ *  @date 2021.
+ *
+ *  @file  BenchGenome.cpp
+ *  @brief Compare per-site and bulk genome access (see core/Genome.hpp).
+ *
+ *  Usage: BenchGenome [genome_size=100000] [reps=100]
+ *
+ *  Each genome is read and written through a Genome reference, as an organism would, once a
+ *  site at a time and once with the bulk (span) accessors; results of the two are compared.
+ */
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "emp/base/vector.hpp"
+#include "emp/bits/BitVector.hpp"
+#include "emp/math/Random.hpp"
+
+#include "../source/core/Genome.hpp"
+
+using bench_clock_t = std::chrono::steady_clock;
+
+template <typename FUN_T>
+double TimeReps(size_t reps, FUN_T && fun) {
+  const auto start = bench_clock_t::now();
+  for (size_t rep = 0; rep < reps; ++rep) fun();
+  return std::chrono::duration<double>(bench_clock_t::now() - start).count();
+}
+
+void PrintResult(const std::string & name, double site_time, double bulk_time,
+                 size_t sites, bool match) {
+  std::cout << name << ": per-site " << sites / site_time / 1e6 << " M sites/sec; bulk "
+            << sites / bulk_time / 1e6 << " M sites/sec (" << site_time / bulk_time << "x)"
+            << (match ? "" : "  ** RESULTS DIFFER **") << std::endl;
+}
+
+/// Time reading all sites as ints and as doubles, then writing them back as doubles.
+template <typename LOCUS_T>
+void BenchValues(const std::string & name, size_t size, size_t reps, emp::Random & random) {
+  mabe::TypedGenome<LOCUS_T> typed_genome;
+  typed_genome.Resize(size);
+  typed_genome.SetAlphabetSize(100.0);
+  typed_genome.Randomize(random);
+  mabe::Genome & genome = typed_genome;
+
+  emp::vector<int> site_ints(size), bulk_ints(size);
+  emp::vector<double> site_doubles(size), bulk_doubles(size);
+
+  double site_time = TimeReps(reps, [&](){
+    for (size_t i = 0; i < size; ++i) site_ints[i] = genome.ReadInt(i);
+  });
+  double bulk_time = TimeReps(reps, [&](){ genome.ReadInts(0, size, bulk_ints.data()); });
+  PrintResult(name + " ReadInts", site_time, bulk_time, size * reps, site_ints == bulk_ints);
+
+  site_time = TimeReps(reps, [&](){
+    for (size_t i = 0; i < size; ++i) site_doubles[i] = genome.ReadDouble(i);
+  });
+  bulk_time = TimeReps(reps, [&](){ genome.ReadDoubles(0, size, bulk_doubles.data()); });
+  PrintResult(name + " ReadDoubles", site_time, bulk_time, size * reps,
+              site_doubles == bulk_doubles);
+
+  site_time = TimeReps(reps, [&](){
+    for (size_t i = 0; i < size; ++i) genome.WriteDouble(i, site_doubles[i]);
+  });
+  bulk_time = TimeReps(reps, [&](){ genome.WriteDoubles(0, size, bulk_doubles.data()); });
+  PrintResult(name + " WriteDoubles", site_time, bulk_time, size * reps,
+              typed_genome.ReadDoubles(0, size) == site_doubles);
+}
+
+/// Time reading and writing bits from a packed bit genome.
+void BenchBits(size_t size, size_t reps, emp::Random & random) {
+  mabe::TypedGenome<bool> typed_genome;
+  typed_genome.Resize(size);
+  typed_genome.Randomize(random);
+  mabe::Genome & genome = typed_genome;
+
+  emp::BitVector site_bits(size), bulk_bits(size);
+  double site_time = TimeReps(reps, [&](){
+    for (size_t i = 0; i < size; ++i) site_bits.Set(i, genome.ReadBit(i));
+  });
+  double bulk_time = TimeReps(reps, [&](){ bulk_bits = genome.ReadBits(0, size); });
+  PrintResult("bool ReadBits", site_time, bulk_time, size * reps, site_bits == bulk_bits);
+
+  // Write starting at an unaligned position, so fields straddle words.
+  const size_t offset = 3;
+  const size_t count = size - offset;
+  emp::BitVector in_bits(count);
+  in_bits.Randomize(random);
+  site_time = TimeReps(reps, [&](){
+    for (size_t i = 0; i < count; ++i) genome.WriteBit(offset + i, in_bits.Get(i));
+  });
+  bulk_time = TimeReps(reps, [&](){ genome.WriteBits(offset, in_bits); });
+  PrintResult("bool WriteBits", site_time, bulk_time, count * reps,
+              genome.ReadBits(offset, count) == in_bits);
+}
+
+int main(int argc, char* argv[])
+{
+  const size_t size = (argc > 1) ? std::stoul(argv[1]) : 100000;
+  const size_t reps = (argc > 2) ? std::stoul(argv[2]) : 100;
+  emp::Random random(1);
+
+  std::cout << "Genome size " << size << ", " << reps << " reps.\n";
+  BenchValues<int>("int", size, reps, random);
+  BenchValues<double>("double", size, reps, random);
+  BenchValues<uint8_t>("uint8_t", size, reps, random);
+  BenchBits(size, reps, random);
+}
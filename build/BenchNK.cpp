@@ -0,0 +1,102 @@
+/**
+ *  @note This file is part of MABE, https://github.com/mercere99/MABE2
+ *  @copyright Copyright (C) Michigan State University, MIT Software license; see doc/LICENSE.md
+ *  @date 2021.
+ *
+ *  @file  BenchNK.cpp
+ *  @brief Time NK landscape evaluation (see tools/NK.hpp) against the original algorithm.
+ *
+ *  Usage: BenchNK [N=1000] [K=8] [num_genomes=1000] [reps=10]
+ *
+ *  The original algorithm copied the genome, doubled it for wrap-around, and shifted the whole
+ *  copy once per gene; it is reproduced here as the baseline.  Every other method must give
+ *  exactly the same fitness (or, for single precision, a close one).
+ */
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "emp/base/vector.hpp"
+#include "emp/bits/BitVector.hpp"
+#include "emp/math/math.hpp"
+#include "emp/math/Random.hpp"
+
+#include "../source/tools/NK-const.hpp"
+#include "../source/tools/NK.hpp"
+
+using bench_clock_t = std::chrono::steady_clock;
+
+/// NKLandscape::GetFitness() as it was originally written.
+double OriginalFitness(const mabe::NKLandscape & landscape, emp::BitVector genome) {
+  const size_t N = landscape.GetN();
+  const size_t K = landscape.GetK();
+  genome.Resize(N*2);
+  genome |= (genome << N);
+
+  double total = 0.0;
+  size_t mask = emp::MaskLow<size_t>(K+1);
+  for (size_t i = 0; i < N; i++) {
+    const size_t cur_val = (genome >> i).GetUInt(0) & mask;
+    total += landscape.GetFitness(i, cur_val);
+  }
+  return total;
+}
+
+int main(int argc, char* argv[])
+{
+  const size_t N = (argc > 1) ? std::stoul(argv[1]) : 1000;
+  const size_t K = (argc > 2) ? std::stoul(argv[2]) : 8;
+  const size_t num_genomes = (argc > 3) ? std::stoul(argv[3]) : 1000;
+  const size_t reps = (argc > 4) ? std::stoul(argv[4]) : 10;
+  const size_t num_evals = num_genomes * reps;
+
+  emp::Random random(1);
+  mabe::NKLandscape landscape(N, K, random);
+  emp::Random float_random(1);                       // Same draws, stored as floats.
+  mabe::NKLandscape float_landscape(N, K, float_random, true);
+
+  emp::vector<emp::BitVector> genomes(num_genomes, emp::BitVector(N));
+  for (emp::BitVector & genome : genomes) genome.Randomize(random);
+
+  std::cout << "N=" << N << " K=" << K << "; " << num_genomes << " genomes, "
+            << reps << " reps.\n";
+
+  // Time one method, reporting microseconds per evaluation and how far it is from reference.
+  emp::vector<double> reference(num_genomes);
+  auto Time = [&](const std::string & name, auto && fitness_fun, bool set_reference=false) {
+    emp::vector<double> results(num_genomes);
+    const auto start = bench_clock_t::now();
+    for (size_t rep = 0; rep < reps; ++rep) {
+      for (size_t g = 0; g < num_genomes; ++g) results[g] = fitness_fun(genomes[g]);
+    }
+    const double seconds = std::chrono::duration<double>(bench_clock_t::now() - start).count();
+    if (set_reference) reference = results;
+    double max_diff = 0.0;
+    for (size_t g = 0; g < num_genomes; ++g) {
+      max_diff = std::max(max_diff, std::abs(results[g] - reference[g]));
+    }
+    std::cout << name << seconds * 1e6 / num_evals << " us/eval  (max difference "
+              << max_diff << ")" << std::endl;
+  };
+
+  Time("Original (copy + shift):  ",
+       [&](const emp::BitVector & g){ return OriginalFitness(landscape, g); }, true);
+  Time("Word windows, flat table: ",
+       [&](const emp::BitVector & g){ return landscape.GetFitness(g); });
+  Time("Single-precision table:   ",
+       [&](const emp::BitVector & g){ return float_landscape.GetFitness(g); });
+
+  if (N == 1000 && K == 8) {
+    auto static_landscape = std::make_unique<emp::evo::NKLandscapeConst<1000,8>>();
+    for (size_t n = 0; n < N; n++) {
+      for (size_t state = 0; state < landscape.GetStateCount(); state++) {
+        static_landscape->SetState(n, state, landscape.GetFitness(n, state));
+      }
+    }
+    Time("Compile-time landscape:   ",
+         [&](const emp::BitVector & g){ return static_landscape->GetFitness(g); });
+  }
+}
@@ -0,0 +1,122 @@
+/**
+ *  @note This file is part of MABE, https://github.com/mercere99/MABE2
+ *  @copyright Copyright (C) Michigan State University, MIT Software license; see doc/LICENSE.md
+ *  @date 2021.
+ *
+ *  @file  BenchSimpleProgram.cpp
+ *  @brief Microbenchmarks for the SimpleProgram interpreter (see tools/SimpleProgram.hpp).
+ *
+ *  Usage: BenchSimpleProgram [genome_length=100] [num_genomes=1000] [max_steps=500] [cases=64]
+ *
+ *  Random genomes are timed for compiling (scope analysis, with and without intron stripping),
+ *  for running one input case at a time, and for running batches of input cases in lanes.
+ *  Outputs from every method are compared against plain one-case-at-a-time execution.
+ */
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "emp/base/vector.hpp"
+#include "emp/math/Random.hpp"
+
+#include "../source/tools/SimpleProgram.hpp"
+#include "../source/tools/SimpleProgramLanes.hpp"
+
+using bench_clock_t = std::chrono::steady_clock;
+using mabe::SimpleProgram;
+
+double SecondsSince(bench_clock_t::time_point start) {
+  return std::chrono::duration<double>(bench_clock_t::now() - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+  const size_t genome_length = (argc > 1) ? std::stoul(argv[1]) : 100;
+  const size_t num_genomes = (argc > 2) ? std::stoul(argv[2]) : 1000;
+  const size_t max_steps = (argc > 3) ? std::stoul(argv[3]) : 500;
+  const size_t num_cases = (argc > 4) ? std::stoul(argv[4]) : 64;
+  constexpr size_t NUM_OUTPUTS = 4;
+  emp::Random random(1);
+
+  // Random genomes (any bytes are legal instructions) and input cases.
+  emp::vector<emp::vector<SimpleProgram::Inst>> genomes(num_genomes);
+  for (auto & genome : genomes) {
+    genome.resize(genome_length);
+    for (SimpleProgram::Inst & inst : genome) {
+      inst.op = (uint8_t) random.GetUInt(SimpleProgram::NUM_OPS);
+      for (uint8_t & arg : inst.args) arg = (uint8_t) random.GetUInt(SimpleProgram::NUM_ARGS);
+    }
+  }
+  emp::vector<emp::vector<double>> inputs(num_cases, emp::vector<double>(8));
+  for (auto & case_inputs : inputs) {
+    for (double & value : case_inputs) value = random.GetDouble(-10.0, 10.0);
+  }
+
+  std::cout << num_genomes << " genomes of " << genome_length << " instructions; up to "
+            << max_steps << " steps per run; " << num_cases << " input cases.\n";
+
+  // Compile speed.
+  emp::vector<SimpleProgram> programs(num_genomes), stripped(num_genomes);
+  auto start = bench_clock_t::now();
+  for (size_t g = 0; g < num_genomes; ++g) programs[g].Compile(genomes[g], false);
+  const double compile_time = SecondsSince(start);
+  start = bench_clock_t::now();
+  for (size_t g = 0; g < num_genomes; ++g) stripped[g].Compile(genomes[g], true);
+  const double strip_time = SecondsSince(start);
+  size_t effective = 0;
+  for (const SimpleProgram & program : stripped) effective += program.GetEffectiveSize();
+
+  std::cout << "Compile:                " << compile_time * 1e6 / num_genomes << " us/genome\n";
+  std::cout << "Compile + strip:        " << strip_time * 1e6 / num_genomes << " us/genome ("
+            << 100.0 * effective / (num_genomes * genome_length) << "% effective)\n";
+
+  // One case at a time; the plain run gives the reference outputs.
+  const size_t num_results = num_genomes * num_cases * NUM_OUTPUTS;
+  emp::vector<double> reference(num_results), results(num_results);
+  SimpleProgram::State state;
+  auto RunOneAtATime = [&](const emp::vector<SimpleProgram> & progs, emp::vector<double> & out) {
+    size_t total_steps = 0;
+    double * out_ptr = out.data();
+    for (const SimpleProgram & program : progs) {
+      for (const emp::vector<double> & case_inputs : inputs) {
+        state.Reset();
+        state.SetInputs(case_inputs);
+        total_steps += program.Run(state, max_steps);
+        state.GetOutputs(out_ptr, NUM_OUTPUTS);
+        out_ptr += NUM_OUTPUTS;
+      }
+    }
+    return total_steps;
+  };
+  auto CountMismatches = [&]() {
+    size_t count = 0;
+    for (size_t i = 0; i < num_results; ++i) {
+      const bool both_nan = reference[i] != reference[i] && results[i] != results[i];
+      if (!both_nan && reference[i] != results[i]) ++count;
+    }
+    return count;
+  };
+
+  start = bench_clock_t::now();
+  const size_t total_steps = RunOneAtATime(programs, reference);
+  const double run_time = SecondsSince(start);
+  std::cout << "Run:                    " << total_steps / run_time / 1e6 << " M steps/sec\n";
+
+  start = bench_clock_t::now();
+  RunOneAtATime(stripped, results);
+  const double strip_run_time = SecondsSince(start);
+  std::cout << "Run (introns stripped): " << total_steps / strip_run_time / 1e6
+            << " M steps/sec  (" << CountMismatches() << " output mismatches)\n";
+
+  // Batches of cases run side-by-side in lanes.
+  mabe::SimpleProgramLanes<8> lanes;
+  start = bench_clock_t::now();
+  for (size_t g = 0; g < num_genomes; ++g) {
+    lanes.RunBatch(stripped[g], inputs, max_steps,
+                   results.data() + g * num_cases * NUM_OUTPUTS, NUM_OUTPUTS);
+  }
+  const double lanes_time = SecondsSince(start);
+  std::cout << "Lanes (8, stripped):    " << total_steps / lanes_time / 1e6
+            << " M steps/sec  (" << CountMismatches() << " output mismatches)\n";
+}
@@ -5,17 +5,33 @@
  *
  *  @file  Genome.hpp
  *  @brief Base genome representation for organisms.
+ *
+ *  Genomes can be accessed one site at a time, or in bulk over a contiguous span of loci
+ *  (ReadInts(start, count, out), WriteDoubles(start, count, in), ReadBits(start, count), etc.).
+ *  The base class implements bulk access with single-site calls; typed genomes override it
+ *  with direct loops over their storage, and TypedGenome<bool> packs sites into an
+ *  emp::BitVector and moves 32 sites at a time.
  */
 
 #ifndef MABE_GENOME_HPP
 #define MABE_GENOME_HPP
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <limits>
+#include <string>
 
+#include "emp/base/assert.hpp"
 #include "emp/base/error.hpp"
+#include "emp/base/Ptr.hpp"
+#include "emp/base/vector.hpp"
+#include "emp/bits/BitVector.hpp"
 #include "emp/math/Random.hpp"
 #include "emp/meta/TypeID.hpp"
 
+#include "../tools/SkipSampler.hpp"
+
 namespace mabe {
 
   // Interface class for all genome types.
@@ -23,6 +39,7 @@ namespace mabe {
   public:
     // Note: No constructors given; Genomes are pure virtual and as such must always   
     //       be constructed via a derived class.
+    virtual ~Genome() { }
 
     virtual emp::Ptr<Genome> Clone() = 0;         // Make an exact copy of this genome.
     virtual emp::Ptr<Genome> CloneProtocol() = 0; // Copy everything in this genome except sequence.
@@ -59,24 +76,69 @@ namespace mabe {
     virtual std::byte ReadByte(size_t index) const = 0;
     virtual bool ReadBit(size_t index) const = 0;
 
-    // NEED MULTI-READ AND MULTI-WRITE.
-    // NEED READS AND WRITES THAT ARE RESTRICTED TO A RANGE
-    // EXAMPLE:
-    virtual int ReadInt(size_t index, int min, int max) const = 0;
+    // Read a value restricted to the range [min, max] (values outside are clamped).
+    virtual int ReadInt(size_t index, int min, int max) const {
+      return std::clamp(ReadInt(index), min, max);
+    }
 
     virtual void WriteInt(size_t index, int value) =  0;
     virtual void WriteDouble(size_t index, double value) =  0;
     virtual void WriteByte(size_t index, std::byte value) =  0;
     virtual void WriteBit(size_t index, bool value) =  0;
 
-    // Genome accessors for multiple values…
-    // TODO:
-    //  emp::span<int> ReadInts(size_t start_index, size_t end_index) =  0;
-    //  emp::span<double> ReadDoubles(size_t start_index, size_t end_index) =  0;
-    //  emp::span<std::byte> ReadBytes(size_t start_index, size_t end_index) =  0;
-    //  emp::BitVector ReadBits(size_t start_index, size_t end_index) =  0;
-    //
-    // + Multi-writes!!
+    // Genome accessors for a span of count values starting at start...
+    // (Defaults use single-site accessors; derived genomes should override for speed.)
+    virtual void ReadInts(size_t start, size_t count, int * out) const {
+      for (size_t i = 0; i < count; i++) out[i] = ReadInt(start + i);
+    }
+    virtual void ReadDoubles(size_t start, size_t count, double * out) const {
+      for (size_t i = 0; i < count; i++) out[i] = ReadDouble(start + i);
+    }
+    virtual void ReadBytes(size_t start, size_t count, std::byte * out) const {
+      for (size_t i = 0; i < count; i++) out[i] = ReadByte(start + i);
+    }
+    virtual emp::BitVector ReadBits(size_t start, size_t count) const {
+      emp::BitVector out(count);
+      for (size_t i = 0; i < count; i++) out.Set(i, ReadBit(start + i));
+      return out;
+    }
+
+    virtual void WriteInts(size_t start, size_t count, const int * in) {
+      for (size_t i = 0; i < count; i++) WriteInt(start + i, in[i]);
+    }
+    virtual void WriteDoubles(size_t start, size_t count, const double * in) {
+      for (size_t i = 0; i < count; i++) WriteDouble(start + i, in[i]);
+    }
+    virtual void WriteBytes(size_t start, size_t count, const std::byte * in) {
+      for (size_t i = 0; i < count; i++) WriteByte(start + i, in[i]);
+    }
+    virtual void WriteBits(size_t start, const emp::BitVector & in) {
+      for (size_t i = 0; i < in.size(); i++) WriteBit(start + i, in[i]);
+    }
+
+    // Convenience versions that return a vector.
+    emp::vector<int> ReadInts(size_t start, size_t count) const {
+      emp::vector<int> out(count);
+      ReadInts(start, count, out.data());
+      return out;
+    }
+    emp::vector<double> ReadDoubles(size_t start, size_t count) const {
+      emp::vector<double> out(count);
+      ReadDoubles(start, count, out.data());
+      return out;
+    }
+
+    // Copy the full sequence of another genome into this one (resizing as needed), or
+    // compare sequences.  Genomes of the same type override these to work a word at a time.
+    virtual void CopyFrom(const Genome & in) {
+      Resize(in.GetSize());
+      for (size_t i = 0; i < in.GetSize(); i++) WriteDouble(i, in.ReadDouble(i));
+    }
+    virtual bool Equals(const Genome & in) const {
+      if (GetSize() != in.GetSize()) return false;
+      for (size_t i = 0; i < GetSize(); i++) if (ReadDouble(i) != in.ReadDouble(i)) return false;
+      return true;
+    }
 
     class Head {
     protected:
@@ -125,14 +187,55 @@ namespace mabe {
       Head & WriteByte(std::byte value) { if (IsValid()) genome->WriteByte(pos, value); return Advance(); }
       Head & WriteBit(bool value) { if (IsValid()) genome->WriteBit(pos, value); return Advance(); }
 
-      // NEED MULTI-READ AND MULTI-WRITE.
-      // NEED READS AND WRITES THAT ARE RESTRICTED TO A RANGE
-      // EXAMPLE OF RANGED-READ:
+      // Ranged read: value is clamped to [min, max].
       int ReadInt(int min, int max) {
         int out = IsValid() ? genome->ReadInt(pos, min, max) : 0; Advance();
         return out;
       }
 
+      // Multi-site reads and writes; moving forward over a span within the genome is done in
+      // bulk, while any other case falls back on one site at a time.
+      bool CanBulk(size_t count) const {
+        return direction == 1 && state == NORMAL && pos + count <= genome->GetSize();
+      }
+
+      Head & ReadInts(size_t count, int * out) {
+        if (!CanBulk(count)) { for (size_t i = 0; i < count; i++) out[i] = ReadInt(); return *this; }
+        genome->ReadInts(pos, count, out);
+        return Advance(count);
+      }
+      Head & ReadDoubles(size_t count, double * out) {
+        if (!CanBulk(count)) { for (size_t i = 0; i < count; i++) out[i] = ReadDouble(); return *this; }
+        genome->ReadDoubles(pos, count, out);
+        return Advance(count);
+      }
+      emp::BitVector ReadBits(size_t count) {
+        if (!CanBulk(count)) {
+          emp::BitVector out(count);
+          for (size_t i = 0; i < count; i++) out.Set(i, ReadBit());
+          return out;
+        }
+        emp::BitVector out = genome->ReadBits(pos, count);
+        Advance(count);
+        return out;
+      }
+
+      Head & WriteInts(size_t count, const int * in) {
+        if (!CanBulk(count)) { for (size_t i = 0; i < count; i++) WriteInt(in[i]); return *this; }
+        genome->WriteInts(pos, count, in);
+        return Advance(count);
+      }
+      Head & WriteDoubles(size_t count, const double * in) {
+        if (!CanBulk(count)) { for (size_t i = 0; i < count; i++) WriteDouble(in[i]); return *this; }
+        genome->WriteDoubles(pos, count, in);
+        return Advance(count);
+      }
+      Head & WriteBits(const emp::BitVector & in) {
+        if (!CanBulk(in.size())) { for (size_t i = 0; i < in.size(); i++) WriteBit(in[i]); return *this; }
+        genome->WriteBits(pos, in);
+        return Advance(in.size());
+      }
+
       void Reset() { pos = 0; state = NORMAL; direction = 1; }
       void ReverseDirection() { direction = -direction; }
 
@@ -157,22 +260,23 @@ namespace mabe {
     using this_t = TypedGenome<LOCUS_T>;
 
     emp::vector<locus_t> data;                        // Actual data in the genome.
-    double mut_p = 0.0;                               // Mutation probability (LOTS TO DO HERE!)
+    SkipSampler mut_skips;                            // Mutation probability (LOTS TO DO HERE!)
     size_t min_size = 0;
-    size_t max_size = std::static_cast<size_t>(-1);
+    size_t max_size = std::numeric_limits<size_t>::max();
 
     double alphabet_size = 4.0;
 
   public:
-    TypedGenome<LOCUS_T>() { }
-    TypedGenome<LOCUS_T>(this_t &) = default;
+    TypedGenome() { }
+    TypedGenome(const this_t &) = default;
 
     emp::Ptr<Genome> Clone() override { return emp::NewPtr<this_t>(*this); }
     emp::Ptr<Genome> CloneProtocol() override {
-      emp::Ptr<Genome> out_ptr = NewPtr<this_t>();
-      out_ptr->mut_p = mut_p;
+      emp::Ptr<this_t> out_ptr = emp::NewPtr<this_t>();
+      out_ptr->mut_skips = mut_skips;
       out_ptr->min_size = min_size;
       out_ptr->max_size = max_size;
+      out_ptr->alphabet_size = alphabet_size;
       return out_ptr;
     }
 
@@ -184,14 +288,30 @@ namespace mabe {
     size_t GetNumBytes() const override { return sizeof(locus_t) * GetSize(); }
     void SetSizeRange(size_t _min, size_t _max) override { min_size = _min, max_size = _max; }
 
+    void SetMutationProbability(double p) { mut_skips.SetProb(p); }
+    void SetAlphabetSize(double size) { alphabet_size = size; }
+
     void Randomize(emp::Random & random, size_t pos) override {
       data[pos] = static_cast<locus_t>( random.GetDouble(alphabet_size) );
     }
+    using Genome::Randomize;
+
+    // Randomize each site with the mutation probability, jumping directly between mutated sites.
+    size_t Mutate(emp::Random & random) override {
+      const size_t N = data.size();
+      size_t num_muts = 0;
+      for (size_t pos = mut_skips.NextSkip(random, N); pos < N;
+           pos += mut_skips.NextSkip(random, N) + 1) {
+        Randomize(random, pos);
+        ++num_muts;
+      }
+      return num_muts;
+    }
 
     // Human-readable (if not easily understandable) shorthand representations.
     // @CAO... needs to be done properly!
     std::string ToString() const override { return "[unknown]"; }
-    void FromString(std::string & in) override { emp_error("Cannot read genome from string."); }
+    void FromString(std::string & /*in*/) override { emp_error("Cannot read genome from string."); }
 
     // Potentially more compressed or structured formats for saving/loading genomes.
     // TODO:
@@ -203,16 +323,170 @@ namespace mabe {
     std::byte ReadByte(size_t index) const override { return static_cast<std::byte>(data[index]); }
     bool ReadBit(size_t index) const override { return static_cast<bool>(data[index]); }
 
-    void WriteInt(size_t index, int value) { data[index] = static_cast<locus_t>(value); }
-    void WriteDouble(size_t index, double value) { data[index] = static_cast<locus_t>(value); }
-    void WriteByte(size_t index, std::byte value) { data[index] = static_cast<locus_t>(value); }
-    void WriteBit(size_t index, bool value) { data[index] = static_cast<locus_t>(value); }
- 
+    void WriteInt(size_t index, int value) override { data[index] = static_cast<locus_t>(value); }
+    void WriteDouble(size_t index, double value) override { data[index] = static_cast<locus_t>(value); }
+    void WriteByte(size_t index, std::byte value) override { data[index] = static_cast<locus_t>(value); }
+    void WriteBit(size_t index, bool value) override { data[index] = static_cast<locus_t>(value); }
+
+    // Bulk accessors work directly on the underlying vector.
+    using Genome::ReadInts;     // Keep the vector-returning versions visible.
+    using Genome::ReadDoubles;
+    void ReadInts(size_t start, size_t count, int * out) const override {
+      emp_assert(start + count <= data.size(), start, count, data.size());
+      const locus_t * in = data.data() + start;
+      for (size_t i = 0; i < count; i++) out[i] = static_cast<int>(in[i]);
+    }
+    void ReadDoubles(size_t start, size_t count, double * out) const override {
+      emp_assert(start + count <= data.size(), start, count, data.size());
+      const locus_t * in = data.data() + start;
+      for (size_t i = 0; i < count; i++) out[i] = static_cast<double>(in[i]);
+    }
+    void ReadBytes(size_t start, size_t count, std::byte * out) const override {
+      emp_assert(start + count <= data.size(), start, count, data.size());
+      const locus_t * in = data.data() + start;
+      for (size_t i = 0; i < count; i++) out[i] = static_cast<std::byte>(in[i]);
+    }
+    void WriteInts(size_t start, size_t count, const int * in) override {
+      emp_assert(start + count <= data.size(), start, count, data.size());
+      locus_t * out = data.data() + start;
+      for (size_t i = 0; i < count; i++) out[i] = static_cast<locus_t>(in[i]);
+    }
+    void WriteDoubles(size_t start, size_t count, const double * in) override {
+      emp_assert(start + count <= data.size(), start, count, data.size());
+      locus_t * out = data.data() + start;
+      for (size_t i = 0; i < count; i++) out[i] = static_cast<locus_t>(in[i]);
+    }
+    void WriteBytes(size_t start, size_t count, const std::byte * in) override {
+      emp_assert(start + count <= data.size(), start, count, data.size());
+      locus_t * out = data.data() + start;
+      for (size_t i = 0; i < count; i++) out[i] = static_cast<locus_t>(in[i]);
+    }
+
+    void CopyFrom(const Genome & in) override {
+      if (auto typed = dynamic_cast<const this_t *>(&in)) data = typed->data;
+      else Genome::CopyFrom(in);
+    }
+    bool Equals(const Genome & in) const override {
+      if (auto typed = dynamic_cast<const this_t *>(&in)) return data == typed->data;
+      return Genome::Equals(in);
+    }
   };
 
+  /// Bit genomes are packed into an emp::BitVector; bulk operations move 32 sites at a time.
   template <>
   class TypedGenome<bool> : public Genome {
-    // FILL ALL THIS OUT USING emp::BitVector instead!!!
+  protected:
+    using this_t = TypedGenome<bool>;
+    static constexpr size_t FIELD_BITS = 32;
+
+    emp::BitVector bits;                              // Actual data in the genome.
+    SkipSampler mut_skips;                            // Probability of each bit flipping.
+    size_t min_size = 0;
+    size_t max_size = std::numeric_limits<size_t>::max();
+
+    size_t NumFields() const { return (bits.size() + FIELD_BITS - 1) / FIELD_BITS; }
+
+    // Get the 32 bits starting at any position (bits past the end are zero).
+    uint32_t GetField(size_t pos) const {
+      const size_t field = pos / FIELD_BITS;
+      const size_t offset = pos % FIELD_BITS;
+      uint64_t value = bits.GetUInt(field);
+      if (offset && field + 1 < NumFields()) value |= ((uint64_t) bits.GetUInt(field + 1)) << 32;
+      return (uint32_t) (value >> offset);
+    }
+
+    // Set the 32 bits starting at any position (which must all be inside the genome).
+    void SetField(size_t pos, uint32_t value) {
+      emp_assert(pos + FIELD_BITS <= bits.size(), pos, bits.size());
+      const size_t field = pos / FIELD_BITS;
+      const size_t offset = pos % FIELD_BITS;
+      if (offset == 0) { bits.SetUInt(field, value); return; }
+      uint64_t cur = bits.GetUInt(field) | (((uint64_t) bits.GetUInt(field + 1)) << 32);
+      const uint64_t mask = ((uint64_t) 0xFFFFFFFF) << offset;
+      cur = (cur & ~mask) | (((uint64_t) value) << offset);
+      bits.SetUInt(field, (uint32_t) cur);
+      bits.SetUInt(field + 1, (uint32_t) (cur >> 32));
+    }
+
+  public:
+    TypedGenome() { }
+    TypedGenome(const this_t &) = default;
+
+    const emp::BitVector & GetBits() const { return bits; }
+
+    emp::Ptr<Genome> Clone() override { return emp::NewPtr<this_t>(*this); }
+    emp::Ptr<Genome> CloneProtocol() override {
+      emp::Ptr<this_t> out_ptr = emp::NewPtr<this_t>();
+      out_ptr->mut_skips = mut_skips;
+      out_ptr->min_size = min_size;
+      out_ptr->max_size = max_size;
+      return out_ptr;
+    }
+
+    size_t GetSize() const override { return bits.size(); }
+    void Resize(size_t new_size) override { bits.Resize(new_size); }
+    void Resize(size_t new_size, double default_val) override {
+      const size_t old_size = bits.size();
+      bits.Resize(new_size);
+      for (size_t i = old_size; i < new_size; i++) bits.Set(i, default_val != 0.0);
+    }
+    size_t GetNumBytes() const override { return (bits.size() + 7) / 8; }
+    void SetSizeRange(size_t _min, size_t _max) override { min_size = _min, max_size = _max; }
+
+    void SetMutationProbability(double p) { mut_skips.SetProb(p); }
+
+    void Randomize(emp::Random & random, size_t pos) override { bits.Set(pos, random.P(0.5)); }
+    void Randomize(emp::Random & random) override { bits.Randomize(random); }
+
+    // Flip each bit with the mutation probability, jumping directly between mutated sites.
+    size_t Mutate(emp::Random & random) override {
+      const size_t N = bits.size();
+      size_t num_muts = 0;
+      for (size_t pos = mut_skips.NextSkip(random, N); pos < N;
+           pos += mut_skips.NextSkip(random, N) + 1) {
+        bits.Toggle(pos);
+        ++num_muts;
+      }
+      return num_muts;
+    }
+
+    std::string ToString() const override { return bits.ToString(); }
+
+    // Genome accessors for individual values…
+    int ReadInt(size_t index) const override { return bits.Get(index); }
+    double ReadDouble(size_t index) const override { return bits.Get(index); }
+    std::byte ReadByte(size_t index) const override { return static_cast<std::byte>(bits.Get(index)); }
+    bool ReadBit(size_t index) const override { return bits.Get(index); }
+
+    void WriteInt(size_t index, int value) override { bits.Set(index, value != 0); }
+    void WriteDouble(size_t index, double value) override { bits.Set(index, value != 0.0); }
+    void WriteByte(size_t index, std::byte value) override { bits.Set(index, value != std::byte(0)); }
+    void WriteBit(size_t index, bool value) override { bits.Set(index, value); }
+
+    // Bulk bit accessors move a full 32-bit field at a time.
+    emp::BitVector ReadBits(size_t start, size_t count) const override {
+      emp_assert(start + count <= bits.size(), start, count, bits.size());
+      emp::BitVector out(count);
+      const size_t full_fields = count / FIELD_BITS;
+      for (size_t i = 0; i < full_fields; i++) out.SetUInt(i, GetField(start + i * FIELD_BITS));
+      for (size_t i = full_fields * FIELD_BITS; i < count; i++) out.Set(i, bits.Get(start + i));
+      return out;
+    }
+    void WriteBits(size_t start, const emp::BitVector & in) override {
+      emp_assert(start + in.size() <= bits.size(), start, in.size(), bits.size());
+      const size_t full_fields = in.size() / FIELD_BITS;
+      for (size_t i = 0; i < full_fields; i++) SetField(start + i * FIELD_BITS, in.GetUInt(i));
+      for (size_t i = full_fields * FIELD_BITS; i < in.size(); i++) bits.Set(start + i, in.Get(i));
+    }
+
+    void CopyFrom(const Genome & in) override {
+      if (auto typed = dynamic_cast<const this_t *>(&in)) bits = typed->bits;
+      else Genome::CopyFrom(in);
+    }
+    bool Equals(const Genome & in) const override {
+      if (auto typed = dynamic_cast<const this_t *>(&in)) return bits == typed->bits;
+      return Genome::Equals(in);
+    }
   };
 
 }
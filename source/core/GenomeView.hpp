@@ -0,0 +1,108 @@
+/**
+ *  @note This file is part of MABE, https://github.com/mercere99/MABE2
+ *  @copyright Copyright (C) Michigan State University, MIT Software license; see doc/LICENSE.md
+ *  @date 2021.
+ *
+ *  @file  GenomeView.hpp
+ *  @brief A read-only trait type that refers to storage inside of an organism.
+ *  @note Status: ALPHA
+ *
+ *  Organism types whose genome IS their output (such as BitsOrg or ValsOrg) can publish a
+ *  GenomeView as their output trait rather than copying the genome into the DataMap every time
+ *  GenerateOutput() is called.  The organism is responsible for keeping the view pointed at its
+ *  own storage (i.e., re-seating it whenever the organism is copied or moved).
+ *
+ *  Modules that read such traits should allow both types when they declare the trait:
+ *
+ *    AddRequiredTrait<emp::BitVector, GenomeView<emp::BitVector>>(bits_trait);
+ *
+ *  and then use a GenomeTraitReader (set up in SetupDataMap()) to access the values without
+ *  caring which form the trait ended up with.
+ */
+
+#ifndef MABE_GENOME_VIEW_H
+#define MABE_GENOME_VIEW_H
+
+#include <iostream>
+#include <string>
+
+#include "emp/base/assert.hpp"
+#include "emp/base/Ptr.hpp"
+#include "emp/data/DataMap.hpp"
+#include "emp/tools/string_utils.hpp"
+
+namespace mabe {
+
+  template <typename T>
+  class GenomeView {
+  private:
+    emp::Ptr<const T> ptr = nullptr;  ///< Storage inside of the organism being viewed.
+
+  public:
+    using value_type = T;
+
+    GenomeView() = default;
+    GenomeView(const T & in) : ptr(&in) { }
+    GenomeView(const GenomeView &) = default;
+    GenomeView & operator=(const GenomeView &) = default;
+
+    bool IsNull() const { return ptr.IsNull(); }
+
+    const T & Get() const {
+      emp_assert(!ptr.IsNull(), "Trying to access an unlinked GenomeView.");
+      return *ptr;
+    }
+    const T & operator*() const { return Get(); }
+    emp::Ptr<const T> operator->() const { return ptr; }
+
+    /// Views are equal if the values they are viewing are equal.
+    bool operator==(const GenomeView & in) const {
+      if (ptr == in.ptr) return true;
+      if (ptr.IsNull() || in.ptr.IsNull()) return false;
+      return *ptr == *in.ptr;
+    }
+    bool operator!=(const GenomeView & in) const { return !(*this == in); }
+
+    std::string ToString() const {
+      if (ptr.IsNull()) return "";
+      return emp::to_string(*ptr);
+    }
+
+    friend std::ostream & operator<<(std::ostream & os, const GenomeView & view) {
+      return os << view.ToString();
+    }
+  };
+
+  /// Helper to read a trait that may be stored either as a value of type T or as a
+  /// GenomeView<T>.  The trait type is looked up once (in SetupDataMap) rather than per access.
+  template <typename T>
+  class GenomeTraitReader {
+  private:
+    size_t trait_id = 0;
+    bool is_view = false;
+
+  public:
+    void Setup(const emp::DataMap & dmap, const std::string & trait_name) {
+      const emp::DataLayout & layout = dmap.GetLayout();
+      emp_assert(layout.HasName(trait_name), trait_name);
+      trait_id = layout.GetID(trait_name);
+      is_view = layout.IsType<GenomeView<T>>(trait_id);
+      emp_assert(is_view || layout.IsType<T>(trait_id), trait_name);
+    }
+
+    size_t GetID() const { return trait_id; }
+    bool IsView() const { return is_view; }
+
+    const T & Get(const emp::DataMap & dmap) const {
+      if (is_view) return dmap.Get<GenomeView<T>>(trait_id).Get();
+      return dmap.Get<T>(trait_id);
+    }
+
+    /// Read the trait directly from an organism (or anything else with a GetDataMap()).
+    template <typename ORG_T>
+    const T & operator()(const ORG_T & org) const { return Get(org.GetDataMap()); }
+  };
+
+}
+
+#endif
@@ -71,6 +71,8 @@ namespace mabe {
 
     TraitManager<ModuleBase> trait_man; ///< Manage consistent read/write access to traits
 
+    bool recombine_warned = false;  ///< Have we warned that an org type cannot recombine?
+
     // --- Config information for command-line arguments ---
     struct ArgInfo {
       std::string name;    ///< E.g.: "help" which would be called with "--help"
@@ -194,6 +196,15 @@ namespace mabe {
                        OrgPosition target_pos,
                        bool do_mutations=true);
 
+    /// Give birth to one or more offspring that recombine org with a mate; 'before repro' is
+    /// only triggered for the primary parent (at ppos).
+    Collection DoBirth(const Organism & org,
+                       OrgPosition ppos,
+                       Organism & mate,
+                       Population & target_pop,
+                       size_t birth_count=1,
+                       bool do_mutations=true);
+
 
     /// A shortcut to DoBirth where only the parent position needs to be supplied;
     /// Return all offspring placed.
@@ -706,6 +717,44 @@ namespace mabe {
     return target_pos;
   }
 
+  Collection MABE::DoBirth(const Organism & org,
+                           OrgPosition ppos,
+                           Organism & mate,
+                           Population & target_pop,
+                           size_t birth_count,
+                           bool do_mutations) {
+    emp_assert(org.IsEmpty() == false);             // Empty cells cannot reproduce.
+    emp_assert(mate.IsEmpty() == false);
+    before_repro_sig.Trigger(ppos);                 // Signal reproduction event.
+    OrgPosition pos;                                // Position of each offspring placed.
+    emp::Ptr<Organism> new_org;
+    emp::Ptr<Organism> mate_ptr = &mate;
+    Collection birth_list;                          // Track positions of all offspring.
+    for (size_t i = 0; i < birth_count; i++) {      // Loop through offspring, adding each
+      if (do_mutations) new_org = org.MakeOffspringOrganism(mate_ptr, random);
+      else new_org = org.CanRecombine() ? org.RecombineOrganisms(mate_ptr, random) : nullptr;
+      if (!new_org) {                               // Fall back to a copy of the first parent.
+        if (!recombine_warned) {
+          emp::notify::Warning("Organism type cannot recombine; offspring copied from one parent.");
+          recombine_warned = true;
+        }
+        new_org = do_mutations ? org.MakeOffspringOrganism(random) : org.CloneOrganism();
+      }
+
+      // Alert modules that offspring is ready, then find its birth position.
+      on_offspring_ready_sig.Trigger(*new_org, ppos, target_pop);
+      pos = target_pop.PlaceBirth(*new_org, ppos);
+
+      // If this placement is valid, do so.  Otherwise delete the organism.
+      if (pos.IsValid()) {
+        AddOrgAt(new_org, pos, ppos);
+        birth_list.Insert(pos);
+      }
+      else new_org.Delete();
+    }
+    return birth_list;
+  }
+
   void MABE::MoveOrgs(Population & from_pop, Population & to_pop, bool reset_to) {
     // Get the starting point for the new organisms to ove to.
     Population::iterator_t it_to = reset_to ? to_pop.begin() : to_pop.end();
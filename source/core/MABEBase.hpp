@@ -59,9 +59,9 @@ namespace mabe {
     // OnPlacement(OrgPosition placement_pos)
     SigListener<ModuleBase,void,OrgPosition> on_placement_sig;
     // BeforeMutate(Organism & org)
-    SigListener<ModuleBase,void,Organism &> before_mutate_sig; // TO IMPLEMENT
+    SigListener<ModuleBase,void,Organism &> before_mutate_sig;
     // OnMutate(Organism & org)
-    SigListener<ModuleBase,void,Organism &> on_mutate_sig; // TO IMPLEMENT
+    SigListener<ModuleBase,void,Organism &> on_mutate_sig;
     // BeforeDeath(OrgPosition remove_pos)
     SigListener<ModuleBase,void,OrgPosition> before_death_sig;
     // BeforeSwap(OrgPosition pos1, OrgPosition pos2)
@@ -131,6 +131,20 @@ namespace mabe {
       on_placement_sig.Trigger(pos);                     // Notify listeners org has been placed.
     }
 
+    /// All mutations of organisms during births should come through MutateOrg so that modules
+    /// are notified before and after the genome changes.  The default OrgType::MakeOffspring()
+    /// functions call it (through their manager's MutateOffspring()).
+    /// @param[in] org is the organism to be mutated (typically a new offspring).
+    /// @param[in] mut_random is the random number generator to mutate with.
+    /// @return the number of mutations that occurred.
+    size_t MutateOrg(Organism & org, emp::Random & mut_random) {
+      before_mutate_sig.Trigger(org);                // Notify listeners org is about to mutate.
+      const size_t num_muts = org.Mutate(mut_random); // Apply mutations.
+      on_mutate_sig.Trigger(org);                    // Notify listeners org has mutated.
+      return num_muts;
+    }
+    size_t MutateOrg(Organism & org) { return MutateOrg(org, random); }
+
     /// All permanent deletion of organisms from a population should come through here.
     /// If the relevant position is already empty, nothing happens.
     /// After the position is cleared, caller must replace (possibly with an empty org) or resize away.
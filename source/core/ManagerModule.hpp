@@ -95,6 +95,11 @@ namespace mabe {
       return obj_ptr;
     }
 
+    /// Mutate a new offspring through the controller, so modules get the mutate signals.
+    size_t MutateOffspring_impl(OrgType & offspring, emp::Random & random) override {
+      return control.MutateOrg((managed_t &) offspring, random);
+    }
+
 
     void SetupModule() override {
       obj_prototype->SetupModule();
@@ -108,6 +113,16 @@ namespace mabe {
       obj_prototype->SetupConfig();
     }
 
+    /// In verbose mode, report how much storage is shared between the managed objects.
+    void OnUpdate(size_t update) override {
+      const std::string stats = control.GetVerbose() ? obj_prototype->GetSharingStats() : "";
+      if (stats.empty()) {          // Nothing to report; stop listening for updates.
+        Module::OnUpdate(update);
+        return;
+      }
+      control.Verbose(GetName(), " (update ", update, "): ", stats);
+    }
+
   };
 
   /// Build a class that will automatically register modules when created (globally)
@@ -37,6 +37,11 @@
 namespace mabe {
 
   class Module : public ModuleBase {
+  private:
+    std::string eval_pos_trait = "";  ///< Trait tracking when this module last evaluated each org.
+    std::string eval_epoch_trait = "";  ///< Trait with eval_epoch at each org's last evaluation.
+    size_t eval_epoch = 1;            ///< Bumped whenever earlier evaluations become invalid.
+
   public:
     Module(MABE & in_control, const std::string & in_name, const std::string & in_desc="")
       : ModuleBase(in_control, in_name, in_desc) { }
@@ -186,6 +191,60 @@ namespace mabe {
     }
 
 
+    // ---== Output Generation ==---
+
+    /// Run GenerateOutput() on every organism in a collection; organisms are handed to their
+    /// type in groups (see OrgType::GenerateOutputs()) so they can share work.
+    void GenerateOutputs(Collection & orgs) const {
+      emp::vector<emp::Ptr<const Module>> managers;
+      emp::vector<emp::vector<emp::Ptr<OrgType>>> groups;
+      for (Organism & org : orgs) {
+        const emp::Ptr<const Module> manager = &org.GetManager();
+        size_t id = 0;
+        while (id < managers.size() && managers[id] != manager) ++id;
+        if (id == managers.size()) {
+          managers.push_back(manager);
+          groups.emplace_back();
+        }
+        groups[id].push_back(&org);
+      }
+      for (const auto & group : groups) group[0]->GenerateOutputs(group);
+    }
+
+
+    // ---== Incremental Evaluation ==---
+
+    /// Track the point in each organism's mutation history at which this module last evaluated
+    /// it, so that later evaluations can rescore only the sites that have changed since.
+    void AddEvaluationTracking() {
+      eval_pos_trait = emp::to_string(GetName(), "_eval_pos");
+      eval_epoch_trait = emp::to_string(GetName(), "_eval_epoch");
+      AddPrivateTrait<size_t>(eval_pos_trait, "Mutation history position at last evaluation.", 0);
+      AddPrivateTrait<size_t>(eval_epoch_trait, "Evaluation epoch at last evaluation.", 0);
+    }
+
+    /// Mark all earlier evaluations as out of date (e.g., the fitness function has changed), so
+    /// the next evaluation of each organism is a full one.
+    void InvalidateEvaluations() { ++eval_epoch; }
+
+    /// Collect the sites changed in org since this module last evaluated it (see
+    /// MutationHistory::GetChangesSince()); return false if a full evaluation is needed.
+    bool GetChangesSinceEval(const Organism & org, MutationLog & changes) const {
+      emp_assert(eval_pos_trait != "", "AddEvaluationTracking() must be called in SetupModule().");
+      if (org.GetTrait<size_t>(eval_epoch_trait) != eval_epoch) return false;
+      emp::Ptr<const MutationHistory> history = org.GetMutationHistory();
+      if (!history) return false;
+      return history->GetChangesSince(org.GetTrait<size_t>(eval_pos_trait), changes);
+    }
+
+    /// Record that this module's traits for org are now up to date with its genome.
+    void MarkEvaluated(Organism & org) const {
+      emp::Ptr<const MutationHistory> history = org.GetMutationHistory();
+      org.SetTrait<size_t>(eval_pos_trait, history ? history->GetEndPos() : 0);
+      org.SetTrait<size_t>(eval_epoch_trait, eval_epoch);
+    }
+
+
     // ---== Signal Handling ==---
 
     // Functions to be called based on signals.  Note that the existence of an overridden version
@@ -70,6 +70,7 @@
 
 #include "../Emplode/Emplode.hpp"
 
+#include "MutationLog.hpp"
 #include "TraitInfo.hpp"
 
 namespace mabe {
@@ -155,6 +156,10 @@ namespace mabe {
       emp_assert(false, "Make_impl() must be overridden for ManagerModule.");
       return nullptr;
     }
+    virtual size_t MutateOffspring_impl(OrgType &, emp::Random &) {
+      emp_assert(false, "MutateOffspring_impl() must be overridden for ManagerModule.");
+      return 0;
+    }
 
   public:
     ModuleBase(MABE & in_control, const std::string & in_name, const std::string & in_desc="")
@@ -257,6 +262,13 @@ namespace mabe {
 
     virtual bool OK() const = 0;  // For debugging purposes only.
 
+    // ---=== Specialty Functions for Evaluation Modules ===---
+
+    /// Evaluate a single organism, storing the results in its traits.  Modules may use the
+    /// organism's mutation history to rescore only the sites changed since they last evaluated
+    /// it.  Returns false if one-at-a-time evaluation is not supported by this module.
+    virtual bool EvaluateOrg(Organism &) { return false; }
+
     // ---=== Specialty Functions for Organism Managers ===---
     virtual emp::TypeID GetObjType() const {
       emp_assert(false, "GetObjType() must be overridden for ManagerModule.");
@@ -278,6 +290,10 @@ namespace mabe {
     emp::Ptr<OBJ_T> Make(emp::Random & random) {
       return Make_impl(random).template DynamicCast<OBJ_T>();
     }
+    /// Mutate a new offspring, signaling modules before and after (see MABEBase::MutateOrg()).
+    size_t MutateOffspring(OrgType & offspring, emp::Random & random) {
+      return MutateOffspring_impl(offspring, random);
+    }
   };
 
   struct ModuleInfo {
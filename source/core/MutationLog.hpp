@@ -0,0 +1,123 @@
+/**
+ *  @note This file is part of MABE, https://github.com/mercere99/MABE2
+ *  @copyright Copyright (C) Michigan State University, MIT Software license; see doc/LICENSE.md
+ *  @date 2021.
+ *
+ *  @file  MutationLog.hpp
+ *  @brief A record of the genome sites changed by mutations, so they can be undone or rescored.
+ *  @note Status: ALPHA
+ *
+ *  Organisms that support in-place refinement fill out a MutationLog as they mutate, listing
+ *  each site changed and the value it held beforehand.  The log can then be handed back to the
+ *  organism to revert the changes, or to an evaluation module so that it only needs to rescore
+ *  the parts of the genome that actually changed.
+ *
+ *  Values are stored as doubles, which can exactly represent bits, small integers, or reals.
+ *  Each site should be listed at most once per set of mutations.
+ *
+ *  A MutationHistory is kept inside an organism to track all of the mutations it has undergone
+ *  since it was copied from its parent.  Each change gets an absolute position, so every
+ *  evaluation module can remember the position it last scored the organism at and later ask
+ *  for just the changes made since then.  Copying a history keeps its positions but drops the
+ *  changes themselves (the parent's evaluations will already have seen them); if changes
+ *  are ever lost, a full evaluation is requested instead.
+ */
+
+#ifndef MABE_MUTATION_LOG_H
+#define MABE_MUTATION_LOG_H
+
+#include <algorithm>
+#include <utility>
+
+#include "emp/base/assert.hpp"
+#include "emp/base/vector.hpp"
+
+namespace mabe {
+
+  class MutationLog {
+  private:
+    emp::vector<size_t> sites;       ///< Genome positions changed, in the order they changed.
+    emp::vector<double> old_values;  ///< Value held at each site before it was changed.
+    bool can_undo = true;            ///< Was everything needed to undo these changes recorded?
+
+  public:
+    /// Prepare for a new set of mutations (keeps allocated memory).
+    void Clear() {
+      sites.resize(0);
+      old_values.resize(0);
+      can_undo = true;
+    }
+
+    /// Record that a site is about to change from old_value.
+    void AddSite(size_t site, double old_value) {
+      sites.push_back(site);
+      old_values.push_back(old_value);
+    }
+
+    /// Indicate that the organism type could not record its changes (so they cannot be undone).
+    void SetNoUndo() { can_undo = false; }
+
+    bool CanUndo() const { return can_undo; }
+    bool IsEmpty() const { return sites.size() == 0; }
+    size_t GetSize() const { return sites.size(); }
+    size_t GetSite(size_t id) const { emp_assert(id < sites.size()); return sites[id]; }
+    double GetOldValue(size_t id) const { emp_assert(id < old_values.size()); return old_values[id]; }
+    const emp::vector<size_t> & GetSites() const { return sites; }
+  };
+
+  class MutationHistory {
+  private:
+    static constexpr size_t MAX_SITES = 1024;  ///< Forget changes rather than keep more.
+
+    MutationLog log;         ///< All changes still remembered.
+    size_t start_pos = 1;    ///< Absolute position of the first change in log (0 = never scored).
+
+  public:
+    MutationHistory() = default;
+    MutationHistory(const MutationHistory & in) : start_pos(in.GetEndPos()) { }
+    MutationHistory & operator=(const MutationHistory & in) {
+      log.Clear();
+      start_pos = in.GetEndPos();
+      return *this;
+    }
+
+    /// Position that the next change will be recorded at.
+    size_t GetEndPos() const { return start_pos + log.GetSize(); }
+
+    /// Record that a site is about to change from old_value.
+    void AddSite(size_t site, double old_value) {
+      if (log.GetSize() >= MAX_SITES) ForgetAll();
+      else log.AddSite(site, old_value);
+    }
+
+    /// Indicate that the genome has been changed in unrecorded ways (e.g., by recombination);
+    /// all earlier positions will need a full evaluation.
+    void ForgetAll() {
+      start_pos = GetEndPos() + 1;
+      log.Clear();
+    }
+
+    /// Collect each site changed since position pos (once, with the value it had at pos),
+    /// sorted by site.  Returns false if those changes are unknown.
+    bool GetChangesSince(size_t pos, MutationLog & changes) const {
+      changes.Clear();
+      if (pos < start_pos || pos > GetEndPos()) return false;
+
+      // Sort changes by site (then by time) and keep the earliest change at each site.
+      thread_local emp::vector<std::pair<size_t, size_t>> order;
+      order.resize(0);
+      for (size_t id = pos - start_pos; id < log.GetSize(); ++id) {
+        order.emplace_back(log.GetSite(id), id);
+      }
+      std::sort(order.begin(), order.end());
+      for (size_t i = 0; i < order.size(); ++i) {
+        if (i > 0 && order[i].first == order[i-1].first) continue;
+        changes.AddSite(order[i].first, log.GetOldValue(order[i].second));
+      }
+      return true;
+    }
+  };
+
+}
+
+#endif
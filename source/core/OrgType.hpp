@@ -12,6 +12,7 @@
 #define MABE_ORG_TYPE_HPP
 
 #include "ModuleBase.hpp"
+#include "MutationLog.hpp"
 
 namespace mabe {
 
@@ -52,6 +53,29 @@ namespace mabe {
     /// @note For evolution to function, we need to be able to mutate offspring.
     virtual size_t Mutate(emp::Random & random) = 0;
 
+    /// Mutate this organism in place, recording each changed site (and its prior value) in log
+    /// so that the changes can be undone with RevertMutations().
+    /// @note Required for in-place local search.  If not overridden, no mutations are made and
+    /// the log is marked as unable to undo.
+    virtual size_t MutateWithUndo(emp::Random & /* random */, MutationLog & log) {
+      log.Clear();
+      log.SetNoUndo();
+      return 0;
+    }
+
+    /// Restore the sites listed in log (from a prior MutateWithUndo()) to their old values.
+    /// @return false if this organism type cannot revert mutations.
+    virtual bool RevertMutations(const MutationLog & /* log */) { return false; }
+
+    /// Get the record of sites this organism has had changed (by mutations or reverts) since it
+    /// was copied, so that evaluation modules can rescore just those sites.
+    /// @note Optional; if nullptr is returned, organisms will always be fully re-evaluated.
+    virtual emp::Ptr<const MutationHistory> GetMutationHistory() const { return nullptr; }
+
+    /// Can this organism type produce offspring with Recombine()?
+    /// @note Override to return true along with Recombine().
+    virtual bool CanRecombine() const { return false; }
+
     /// Merge this organism's genome with that of another organism to produce an offspring.
     /// @note Required for basic sexual recombination to work.
     [[nodiscard]] virtual emp::Ptr<OrgType>
@@ -71,18 +95,21 @@ namespace mabe {
     }
 
     /// Produce an asexual offspring WITH MUTATIONS.  By default, use Clone() and then Mutate().
+    /// @note Mutations made through the manager's MutateOffspring() trigger the before_mutate
+    /// and on_mutate signals; overrides should do the same rather than calling Mutate().
     [[nodiscard]] virtual emp::Ptr<OrgType> MakeOffspring(emp::Random & random) const {
       emp::Ptr<OrgType> offspring = Clone();
-      offspring->Mutate(random);
+      manager.MutateOffspring(*offspring, random);
       return offspring;
     }
 
     /// Produce an sexual (two parent) offspring WITH MUTATIONS.  By default, use Recombine() and
-    /// then Mutate().
+    /// then Mutate().  Returns nullptr if this organism type cannot recombine.
     [[nodiscard]] virtual emp::Ptr<OrgType>
     MakeOffspring(emp::Ptr<OrgType> parent2, emp::Random & random) const {
+      if (!CanRecombine()) return nullptr;
       emp::Ptr<OrgType> offspring = Recombine(parent2, random);
-      offspring->Mutate(random);
+      if (offspring) manager.MutateOffspring(*offspring, random);
       return offspring;
     }
 
@@ -91,7 +118,7 @@ namespace mabe {
     [[nodiscard]] virtual emp::vector<emp::Ptr<OrgType>> 
     MakeOffspring(emp::vector<emp::Ptr<OrgType>> other_parents, emp::Random & random) const {
       emp::vector<emp::Ptr<OrgType>> all_offspring = Recombine(other_parents, random);
-      for (auto offspring : all_offspring) offspring->Mutate(random);
+      for (auto offspring : all_offspring) manager.MutateOffspring(*offspring, random);
       return all_offspring;
     }
 
@@ -100,6 +127,12 @@ namespace mabe {
     /// is not overridden, try to the equivalent function in the organism manager.
     virtual std::string ToString() const { return "__unknown__"; }
 
+    /// Get a hash of everything that determines how this organism responds to inputs, so that
+    /// organisms with equal hashes can be assumed to behave identically.
+    /// @note Optional; return 0 (the default) if behavior is unknown or depends on more than the
+    /// genome (e.g., persistent internal state), and results will never be reused.
+    virtual size_t GetGenomeHash() const { return 0; }
+
     /// By default print an organism by triggering it's ToString() function.
     std::ostream & Print(std::ostream & os) const {
       os << ToString();
@@ -117,6 +150,24 @@ namespace mabe {
     /// Run the organism to generate an output in the pre-configured data_map entries.
     virtual void GenerateOutput() { ; }
 
+    /// Run the organism on a whole table of input cases at once, writing results into a
+    /// case-by-output matrix (stored row-major: outputs[case * num_outputs + output_id]).
+    /// Missing outputs are set to 0.0.  The outputs vector is resized as needed, so reusing the
+    /// same vector across calls avoids allocation.
+    /// @return false if this organism type does not support batch evaluation; the caller should
+    ///         then fall back on GenerateOutput() for each case.
+    virtual bool GenerateOutputBatch(const emp::vector<emp::vector<double>> & /*inputs*/,
+                                     emp::vector<double> & /*outputs*/,
+                                     size_t /*num_outputs*/) {
+      return false;
+    }
+
+    /// Run GenerateOutput() on a set of organisms that all share this organism's type.  Types
+    /// that can share work between organisms (e.g., identical genomes) should override this.
+    virtual void GenerateOutputs(const emp::vector<emp::Ptr<OrgType>> & orgs) {
+      for (emp::Ptr<OrgType> org : orgs) org->GenerateOutput();
+    }
+
     /// Run the organisms a single time step; only implemented for continuous execution organisms.
     virtual bool ProcessStep() { return false; }
  
@@ -133,6 +184,10 @@ namespace mabe {
 
     /// Setup organism-specific traits.
     virtual void SetupModule() { ; }
+
+    /// Describe storage that is shared between organisms of this type (such as copy-on-write
+    /// genomes), for reporting in verbose mode.  Return "" if there is nothing to report.
+    virtual std::string GetSharingStats() const { return ""; }
   };
 
 }
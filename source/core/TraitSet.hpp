@@ -6,7 +6,8 @@
  *  @file  TraitSet.hpp
  *  @brief A collection of traits with the same type (or collections of that type).
  *
- *  A TraitSet is used to keep track of a collection of related traits in a module.
+ *  A TraitSet is used to keep track of a collection of related traits in a module.  Collections
+ *  of values can be stored as an emp::vector, a GenomeView of one, or an InlineTraitVector.
  * 
  *  @CAO: Should this class be moved into Empirical proper?
  */
@@ -22,15 +23,37 @@
 #include "emp/tools/string_utils.hpp"
 #include "emp/datastructs/vector_utils.hpp"
 
+#include "../tools/InlineVector.hpp"
+#include "GenomeView.hpp"
+
 namespace mabe {
 
   template <typename T>
   class TraitSet {
+  public:
+    /// A read-only range of the values held by one vector trait.
+    struct ValueRange {
+      const T * ptr = nullptr;
+      size_t count = 0;
+
+      size_t size() const { return count; }
+      const T * begin() const { return ptr; }
+      const T * end() const { return ptr + count; }
+      const T & operator[](size_t pos) const {
+        emp_assert(pos < count, pos, count);
+        return ptr[pos];
+      }
+    };
+
   private:
+    /// How is each vector trait stored?
+    enum VectorKind { VECTOR_DIRECT, VECTOR_VIEW, VECTOR_INLINE };
+
     emp::vector<std::string> base_names;
     emp::vector<std::string> vector_names;
     emp::vector<size_t> base_IDs;
     emp::vector<size_t> vector_IDs;
+    emp::vector<VectorKind> vector_kinds;
     emp::vector<size_t> vec_sizes;
 
     emp::Ptr<const emp::DataLayout> layout;
@@ -49,7 +72,7 @@ namespace mabe {
 
     void Clear() {
       base_names.resize(0); vector_names.resize(0);
-      base_IDs.resize(0); vector_IDs.resize(0); vec_sizes.resize(0);
+      base_IDs.resize(0); vector_IDs.resize(0); vector_kinds.resize(0); vec_sizes.resize(0);
       num_values = 0;
     }
 
@@ -72,6 +95,17 @@ namespace mabe {
         else if (layout->IsType<emp::vector<T>>(id)) {
           vector_names.push_back(name);
           vector_IDs.push_back(id);
+          vector_kinds.push_back(VECTOR_DIRECT);
+        }
+        else if (layout->IsType<GenomeView<emp::vector<T>>>(id)) {
+          vector_names.push_back(name);
+          vector_IDs.push_back(id);
+          vector_kinds.push_back(VECTOR_VIEW);
+        }
+        else if (layout->IsType<InlineTraitVector<T>>(id)) {
+          vector_names.push_back(name);
+          vector_IDs.push_back(id);
+          vector_kinds.push_back(VECTOR_INLINE);
         }
         else {
           error_trait = name;
@@ -105,6 +139,25 @@ namespace mabe {
       return base_IDs.size() + vector_IDs.size();
     }
 
+    /// Get the values associated with a vector trait (however they are stored).
+    ValueRange GetVector(const emp::DataMap & dmap, size_t vec_index) const {
+      const size_t trait_id = vector_IDs[vec_index];
+      switch (vector_kinds[vec_index]) {
+      case VECTOR_VIEW: {
+        const emp::vector<T> & vec = dmap.Get<GenomeView<emp::vector<T>>>(trait_id).Get();
+        return ValueRange{ vec.data(), vec.size() };
+      }
+      case VECTOR_INLINE: {
+        const InlineTraitVector<T> & vec = dmap.Get<InlineTraitVector<T>>(trait_id);
+        return ValueRange{ vec.data(), vec.size() };
+      }
+      default: {
+        const emp::vector<T> & vec = dmap.Get<emp::vector<T>>(trait_id);
+        return ValueRange{ vec.data(), vec.size() };
+      }
+      }
+    }
+
     /// Count the total number of individual values across all traits and store for future use.
     size_t CountValues(const emp::DataMap & dmap) {
       emp_assert(!layout.IsNull());
@@ -113,8 +166,7 @@ namespace mabe {
       num_values = base_IDs.size();
       vec_sizes.resize(vector_IDs.size());
       for (size_t i = 0; i < vector_IDs.size(); ++i) {
-        const size_t id = vector_IDs[i];
-        const size_t cur_size = dmap.Get<emp::vector<T>>(id).size();
+        const size_t cur_size = GetVector(dmap, i).size();
         num_values += cur_size;
         vec_sizes[i] = cur_size;
       }
@@ -138,8 +190,8 @@ namespace mabe {
       }
 
       // Collect the vector values.
-      for (size_t trait_id : vector_IDs) {
-        const emp::vector<T> & cur_vec = dmap.Get<emp::vector<T>>(trait_id);
+      for (size_t i = 0; i < vector_IDs.size(); ++i) {
+        const ValueRange cur_vec = GetVector(dmap, i);
         out.insert(out.end(), cur_vec.begin(), cur_vec.end());
       }
     }
@@ -170,8 +222,7 @@ namespace mabe {
           size_t vid = 0;
           bool found = false;
           while (vid < vector_IDs.size()) {
-            const size_t trait_id = vector_IDs[vid];
-            const emp::vector<T> & cur_vec = dmap.Get<emp::vector<T>>(trait_id);
+            const ValueRange cur_vec = GetVector(dmap, vid);
             if (vector_pos < cur_vec.size()) {
               out[id] = cur_vec[vector_pos];
               found = true;
@@ -199,7 +250,7 @@ namespace mabe {
         value_index -= vec_sizes[vec_index];
         vec_index++;
       }
-      return dmap.Get<emp::vector<T>>(vector_IDs[vec_index])[value_index];
+      return GetVector(dmap, vec_index)[value_index];
     }
 
     void PrintDebug() const {
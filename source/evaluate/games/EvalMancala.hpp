@@ -5,15 +5,43 @@
  *
  *  @file  EvalMancala.hpp
  *  @brief MABE Evaluation module that has organisms play Mancala.
+ *
+ *  Games are played on a compact MancalaBoard (see tools/MancalaBoard.hpp).  Players are
+ *  passed to PlayGame() as plain callable objects, so organism and random moves are made
+ *  without std::function calls, board copies, or per-move allocation.
+ *
+ *  Organisms can face random or AI opponents, or each other.  Organism-vs-organism tournaments
+ *  (random opponents, round robin, or Swiss) are played in rounds where each organism is in at
+ *  most one match (see tools/MatchScheduler.hpp), so a round's matches can run on separate
+ *  threads without two threads ever driving the same organism.  Each match is two games (one
+ *  with each player going first), and results are combined in match order afterwards, so
+ *  the outcome does not depend on num_threads.  Organism traits hold the average per match.
+ *  With an odd number of organisms one sits out each round, so num_rounds rounds give each
+ *  organism either num_rounds or num_rounds-1 matches (byes rotate between organisms).
+ *
+ *  Games between organisms (or against the deterministic AI) are fully determined by the
+ *  players' genomes, so with cache_size > 0 their outcomes are remembered in an LRU cache keyed
+ *  by (genome hash, genome hash, first player).  A game with the two players swapped is the
+ *  same game seen from the other side, so it is stored only once.  Repeated games (from the
+ *  cache or earlier in the same round) are looked up instead of played.  Organism types must
+ *  provide GetGenomeHash() for their games to be cached.
+ *
+ *  The "ai" opponent is an alpha-beta search looking ai_depth moves ahead (see
+ *  tools/MancalaAI.hpp).  Its transposition table is emptied at the start of each evaluation
+ *  and then shared by every game (on every thread) in that evaluation.  The AI's moves depend
+ *  only on the board, so games against it stay deterministic and can be cached.
  */
 
 #ifndef MABE_EVAL_MANCALA_HPP
 #define MABE_EVAL_MANCALA_HPP
 
-#include "emp/games/Mancala.hpp"
-
 #include "../../core/MABE.hpp"
 #include "../../core/Module.hpp"
+#include "../../tools/LRUCache.hpp"
+#include "../../tools/MancalaAI.hpp"
+#include "../../tools/MancalaBoard.hpp"
+#include "../../tools/MatchScheduler.hpp"
+#include "../../tools/StreamHash.hpp"
 
 namespace mabe {
 
@@ -29,12 +57,21 @@ namespace mabe {
     /// What type of opponent should we use?
     enum Opponent {
       RANDOM_MOVES,     // Opponent will always choose a random, legal move.
-      AI,               // Opponent is a human-crafted AI.
-      RANDOM_ORG,       // Opponent is a random organism from the population.
+      AI,               // Opponent is an alpha-beta search AI.
+      RANDOM_ORG,       // Opponents are random organisms from the population.
+      ROUND_ROBIN,      // Every organism plays every other organism.
+      SWISS,            // Organisms are repeatedly paired with others that have similar scores.
       UNKNOWN
     };
 
-    Opponent opponent_type;
+    Opponent opponent_type = RANDOM_MOVES;
+    size_t num_rounds = 1;     ///< Tournament rounds for random_org and swiss opponents.
+    size_t num_threads = 1;    ///< Threads to run matches on (0 = one per hardware thread).
+    size_t cache_size = 0;     ///< Max number of game outcomes to remember (0 = no caching).
+    size_t ai_depth = 6;       ///< Moves the AI opponent looks ahead.
+    size_t ai_table_bits = 20; ///< The AI's transposition table has 2^ai_table_bits entries.
+
+    MancalaAI ai{1, 0};        ///< Search player for the AI opponent (sized when first used).
 
   public:
     EvalMancala(mabe::MABE & control,
@@ -51,6 +88,9 @@ namespace mabe {
       info.AddMemberFunction("EVAL",
                              [](EvalMancala & mod, Collection list) { return mod.Evaluate(list); },
                              "Evaluate organism's ability to play the game Mancala.");
+      info.AddMemberFunction("CACHE_HIT_RATE",
+                             [](EvalMancala & mod) { return mod.GetCacheHitRate(); },
+                             "Fraction of cacheable games reused (not played) in the last EVAL.");
     }
 
     void SetupConfig() override {
@@ -62,9 +102,17 @@ namespace mabe {
       LinkVar(fitness_trait, "fitness_trait", "Trait with combined success rating.");
       LinkMenu(opponent_type, "opponent_type", "Which type of opponent should organisms face?",
                RANDOM_MOVES, "random", "Always choose a random, legal move.",
-               AI, "ai", "Human supplied (but not very good) AI",
-               RANDOM_ORG, "random_org", "Pick another random organism from collection."
+               AI, "ai", "Alpha-beta search AI looking ai_depth moves ahead.",
+               RANDOM_ORG, "random_org", "Pick another random organism from collection.",
+               ROUND_ROBIN, "round_robin", "Play every other organism in the collection.",
+               SWISS, "swiss", "Play organisms with similar scores, over num_rounds rounds."
       );
+      LinkVar(num_rounds, "num_rounds",
+              "Rounds of organism matches for random_org and swiss (odd counts rotate a bye).");
+      LinkVar(num_threads, "num_threads", "Threads for running matches (0 = use all cores)");
+      LinkVar(cache_size, "cache_size", "Number of deterministic game outcomes to remember (0 = off)");
+      LinkVar(ai_depth, "ai_depth", "Moves the AI opponent looks ahead (cost about doubles per move)");
+      LinkVar(ai_table_bits, "ai_table_bits", "AI transposition table has 2^bits entries (16 bytes each)");
     }
 
     void SetupModule() override {
@@ -74,22 +122,23 @@ namespace mabe {
       AddOwnedTrait<double>(scoreB_trait, "Score for opponent", 0.0);
       AddOwnedTrait<double>(error_trait, "Number of illegal moves attempted", 0.0);
       AddOwnedTrait<double>(fitness_trait, "Combined success rating", 0.0);
+      game_cache.SetCapacity(cache_size);
     }
 
 
     // Determine the next move of an organism.
-    size_t EvalMove(emp::Mancala & game, Organism & org) {
-      // Setup the hardware with proper inputs.
-      org.GetTrait<emp::vector<double>>(input_trait) = game.AsVectorInput(game.GetCurPlayer());
+    size_t EvalMove(const MancalaBoard & board, Organism & org) {
+      // Setup the hardware with proper inputs (reusing the existing input vector).
+      board.FillInputs(board.GetCurPlayer(), org.GetTrait<emp::vector<double>>(input_trait));
 
       // Run the code.
       org.GenerateOutput();
 
-      emp::vector<double> results = org.GetTrait<emp::vector<double>>(output_trait);
+      const emp::vector<double> & results = org.GetTrait<emp::vector<double>>(output_trait);
 
       // Determine the chosen move.
       size_t best_move = 0;
-      const size_t move_cap = std::min<size_t>(results.size(), 6);
+      const size_t move_cap = std::min<size_t>(results.size(), MancalaBoard::NUM_PITS);
       for (size_t i = 1; i < move_cap; i++) {
         if (results[best_move] < results[i]) { best_move = i; }
       }
@@ -98,16 +147,16 @@ namespace mabe {
     }
 
     // Determine the next move with human IO.
-    size_t EvalMove(emp::Mancala & game, std::ostream & os=std::cout, std::istream & is=std::cin) {
+    size_t EvalMove(const MancalaBoard & board, std::ostream & os=std::cout, std::istream & is=std::cin) {
       // Present the current board.
-      game.Print();
+      board.Print(os);
 
       // Request a move from the human.
       char move;
       os << "Move?" << std::endl;
       is >> move;
 
-      while (move < 'A' || move > 'F' || game.GetCurSide()[(size_t)(move-'A')] == 0) {
+      while (move < 'A' || move > 'F' || !board.IsMoveValid((size_t)(move-'A'))) {
         os << "Invalid move! (choose a value 'A' to 'F')" <<  std::endl;
         is.clear();
         is.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
@@ -118,69 +167,203 @@ namespace mabe {
     }
 
     /// A uniform function specification that takes a game state and returns a move to make.
-    using mancala_ai_t = std::function< size_t(emp::Mancala & game) >;
+    /// (PlayGame() accepts any callable with this signature; use this type only if needed.)
+    using mancala_ai_t = std::function< size_t(const MancalaBoard & board) >;
 
     /// Information about the results of a match.
     struct Results {
       size_t scoreA = 0;
       size_t scoreB = 0;
-      size_t num_errors = 0;
+      size_t num_errors = 0;     ///< Illegal moves attempted by player 0.
+      size_t num_errorsB = 0;    ///< Illegal moves attempted by player 1.
 
       double CalcFitness() const {
         return ((double) scoreA) - ((double) scoreB) - ((double) num_errors * 10.0);
       }
+
+      /// The same results from the point of view of player 1.
+      Results Flip() const { return Results{ scoreB, scoreA, num_errorsB, num_errors }; }
+
+      Results & operator+=(const Results & in) {
+        scoreA += in.scoreA;  scoreB += in.scoreB;
+        num_errors += in.num_errors;  num_errorsB += in.num_errorsB;
+        return *this;
+      }
     };
 
-    /// Evaluate a game between two functions that each take the game state as input and return
-    /// their next move as output.
-    /// @param player0 The function to be evaluated
-    /// @param player1 The function to test against
-    /// @param cur_player Which player should make the first move?  (default=0, the organism)
-    /// @param verbose Should we print out extra output? (default=false)
-    /// @param os Output stream for any extra ouput. (default=cout)
-    Results EvalGame(const mancala_ai_t & player0, const mancala_ai_t & player1, bool cur_player=0,
-                    bool verbose=false, std::ostream & os=std::cout) {
-      emp::Mancala game(cur_player==0);
-      size_t round = 0, errors = 0;
-      while (game.IsDone() == false) {
-        // Determine the current player and their move.
-        auto & play_fun = (cur_player == 0) ? player0 : player1;
-        size_t best_move = play_fun(game);
-
-        if (verbose) {
-          os << "round = " << round++ << "   errors = " << errors << std::endl;
-          game.Print(os);
-          char move_sym = (char) ('A' + best_move);
-          os << "Move = " << move_sym;
-          if (game.GetCurSide()[best_move] == 0) {
-            os << " (illegal!)";
+    /// Running totals for one organism across all of its matches.
+    struct MatchTotals {
+      double scoreA = 0.0;
+      double scoreB = 0.0;
+      double num_errors = 0.0;
+      double fitness = 0.0;
+      size_t num_matches = 0;
+
+      void Add(const Results & results) {
+        scoreA += (double) results.scoreA;
+        scoreB += (double) results.scoreB;
+        num_errors += (double) results.num_errors;
+        fitness += results.CalcFitness();
+        ++num_matches;
+      }
+    };
+
+  private:
+    /// Identify a deterministic game by the genome hashes of both players and who moves first.
+    /// A hash1 of zero indicates the AI opponent.
+    struct GameKey {
+      size_t hash0 = 0;
+      size_t hash1 = 0;
+      bool start_player = 0;
+
+      bool operator==(const GameKey & in) const {
+        return hash0 == in.hash0 && hash1 == in.hash1 && start_player == in.start_player;
+      }
+    };
+
+    struct GameKeyHash {
+      size_t operator()(const GameKey & key) const {
+        return StreamHash().Add(key.hash0).Add(key.hash1).Add(key.start_player).Get();
+      }
+    };
+
+    /// A single game to be played (or looked up) during an evaluation.
+    struct GameSlot {
+      emp::Ptr<Organism> org0 = nullptr;  ///< Organism being evaluated.
+      emp::Ptr<Organism> org1 = nullptr;  ///< Opposing organism (nullptr for random or AI).
+      bool start_player = 0;              ///< Who moves first?
+      int seed = 1;                       ///< Random seed for a random-move opponent.
+      bool cacheable = false;             ///< Is this game determined by genomes alone?
+      bool flip = false;                  ///< Is key from org1's point of view?
+      bool known = false;                 ///< Were results found in the cache?
+      size_t source = 0;                  ///< Slot actually playing this game (may be earlier).
+      GameKey key;
+      Results results;                    ///< Results as seen from key.hash0's side.
+    };
+
+    LRUCache<GameKey, Results, GameKeyHash> game_cache;
+    size_t cache_lookups = 0;    ///< Cacheable games in the last evaluation.
+    size_t cache_hits = 0;       ///< ...and how many of those did not need to be played.
+
+    /// Play (or reuse) the games in slots.  Slots 2*i and 2*i+1 form a match on the same pair of
+    /// organisms, so they are run on the same thread; different matches must use different
+    /// organisms.  Afterwards, GetSlotResults() gives each game from org0's point of view.
+    void RunGames(emp::vector<GameSlot> & slots,
+                  std::unordered_map<GameKey, size_t, GameKeyHash> & round_games) {
+      // Look up cacheable games; later copies of a game in this batch reuse the first copy.
+      round_games.clear();
+      for (size_t slot_id = 0; slot_id < slots.size(); ++slot_id) {
+        GameSlot & slot = slots[slot_id];
+        slot.source = slot_id;
+        slot.known = false;
+        if (!slot.cacheable || cache_size == 0) { slot.cacheable = false; continue; }
+        ++cache_lookups;
+        if (game_cache.Get(slot.key, slot.results)) { slot.known = true; ++cache_hits; continue; }
+        auto it = round_games.emplace(slot.key, slot_id).first;
+        if (it->second != slot_id) { slot.source = it->second; ++cache_hits; }
+      }
+
+      // Play the remaining games; each is played from key.hash0's side so results can be stored.
+      RunParallel(slots.size() / 2, num_threads, [this, &slots](size_t match_id) {
+        for (size_t slot_id = match_id * 2; slot_id < match_id * 2 + 2; ++slot_id) {
+          GameSlot & slot = slots[slot_id];
+          if (slot.known || slot.source != slot_id) continue;
+          Organism & org = *slot.org0;
+          auto org_fun = [this,&org](const MancalaBoard & board){ return EvalMove(board, org); };
+          if (slot.org1 && slot.flip) {
+            slot.results = EvalGame(*slot.org1, org, !slot.start_player);
+          }
+          else if (slot.org1) {
+            slot.results = EvalGame(org, *slot.org1, slot.start_player);
+          }
+          else if (opponent_type == AI) {
+            auto ai_fun = [this](const MancalaBoard & board){ return ai.PickMove(board); };
+            slot.results = PlayGame(org_fun, ai_fun, slot.start_player);
+          }
+          else {
+            emp::Random random(slot.seed);
+            auto rand_fun = [&random](const MancalaBoard & board){
+              return PickRandomMancalaMove(board, random);
+            };
+            slot.results = PlayGame(org_fun, rand_fun, slot.start_player);
           }
-          os << std::endl << std::endl;
         }
+      });
 
-        // If the chosen move is illegal, shift through other options.
-        while (game.GetCurSide()[best_move] == 0) {  // Cannot make a move into an empty pit!
-          if (cur_player == 0) errors++;
-          if (++best_move > 5) best_move = 0;
+      // Save newly played games.
+      for (size_t slot_id = 0; slot_id < slots.size(); ++slot_id) {
+        const GameSlot & slot = slots[slot_id];
+        if (slot.cacheable && !slot.known && slot.source == slot_id) {
+          game_cache.Put(slot.key, slot.results);
         }
-
-        // Do the move and determine who goes next.
-        bool go_again = game.DoMove(cur_player, best_move);
-        if (!go_again) cur_player = !cur_player;
       }
+    }
+
+    /// Results of a game in slots (after RunGames()) from the point of view of its org0.
+    static Results GetSlotResults(const emp::vector<GameSlot> & slots, size_t slot_id) {
+      const GameSlot & slot = slots[slot_id];
+      const Results & results = slots[slot.source].results;
+      return slot.flip ? results.Flip() : results;
+    }
+
+    /// Setup a slot for a game between two organisms (org1 = nullptr for random or AI).
+    void SetupSlot(GameSlot & slot, emp::Ptr<Organism> org0, size_t hash0,
+                   emp::Ptr<Organism> org1, size_t hash1, bool start_player) {
+      slot.org0 = org0;
+      slot.org1 = org1;
+      slot.start_player = start_player;
+      slot.flip = false;
+      slot.cacheable = (hash0 != 0) && (org1 ? (hash1 != 0) : (opponent_type == AI));
+      if (!slot.cacheable) return;
+      if (!org1) hash1 = 0;                   // Key for the AI opponent.
+      slot.flip = (hash1 != 0) && (hash1 < hash0);
+      if (slot.flip) slot.key = GameKey{hash1, hash0, !start_player};
+      else slot.key = GameKey{hash0, hash1, start_player};
+    }
+
+  public:
+
+    /// Play a game between two callable objects that each take the board as input and return
+    /// their next move as output.
+    /// @param player0 The player to be evaluated
+    /// @param player1 The player to test against
+    /// @param cur_player Which player should make the first move?  (default=0, the organism)
+    /// @param verbose Should we print out extra output? (default=false)
+    /// @param os Output stream for any extra ouput. (default=cout)
+    template <typename P0_T, typename P1_T>
+    Results PlayGame(P0_T && player0, P1_T && player1, bool cur_player=0,
+                     bool verbose=false, std::ostream & os=std::cout) {
+      size_t errors = 0, errorsB = 0;
+      auto count_error = [&errors, &errorsB](size_t player){ if (player == 0) errors++; else errorsB++; };
+      MancalaBoard board(cur_player);
 
       if (verbose) {
-        os << "Final scores -- A: " << game.ScoreA()
-                  << "   B: " << game.ScoreB()
+        size_t round = 0;
+        auto trace = [&](const MancalaBoard & cur_board, size_t move) {
+          os << "round = " << round++ << "   errors = " << errors << std::endl;
+          cur_board.Print(os);
+          os << "Move = " << (char) ('A' + move);
+          if (!cur_board.IsMoveValid(move)) os << " (illegal!)";
+          os << std::endl << std::endl;
+          return move;
+        };
+        board = PlayMancala(board,
+          [&](const MancalaBoard & b){ return trace(b, player0(b)); },
+          [&](const MancalaBoard & b){ return trace(b, player1(b)); },
+          count_error);
+        os << "Final scores -- A: " << board.ScoreA()
+                  << "   B: " << board.ScoreB()
                   << std::endl;
       }
+      else board = PlayMancala(board, player0, player1, count_error);
 
-      return Results{ game.ScoreA(), game.ScoreB(), errors };
+      return Results{ board.ScoreA(), board.ScoreB(), errors, errorsB };
     }
 
-    /// Convert an organism into a uniform function that can be plugged into Mancala.
-    mancala_ai_t ToOrgFun(mabe::Organism & org) {
-      return [this,&org](emp::Mancala & game){ return EvalMove(game, org); };
+    /// Evaluate a game between two functions (see PlayGame()).
+    Results EvalGame(const mancala_ai_t & player0, const mancala_ai_t & player1, bool cur_player=0,
+                    bool verbose=false, std::ostream & os=std::cout) {
+      return PlayGame(player0, player1, cur_player, verbose, os);
     }
 
     /// Evaluate a game: Organism vs. Organism.
@@ -191,7 +374,9 @@ namespace mabe {
     /// @param os Output stream for any extra ouput. (default=cout)
     Results EvalGame(mabe::Organism & org0, mabe::Organism & org1, bool start_player=0,
                     bool verbose=false, std::ostream & os=std::cout) {
-      return EvalGame(ToOrgFun(org0), ToOrgFun(org1), start_player, verbose, os);
+      return PlayGame([this,&org0](const MancalaBoard & board){ return EvalMove(board, org0); },
+                      [this,&org1](const MancalaBoard & board){ return EvalMove(board, org1); },
+                      start_player, verbose, os);
     }
 
     /// Evaluate a game: Organism vs. random opponent.
@@ -202,22 +387,18 @@ namespace mabe {
     /// @param os Output stream for any extra ouput. (default=cout)
     Results EvalGame(mabe::Organism & org, emp::Random & random, bool start_player=0,
                     bool verbose=false, std::ostream & os=std::cout) {
-      mancala_ai_t rand_fun = [&random](emp::Mancala & game) {
-        size_t move_id = random.GetUInt(6);
-        while (!game.IsMoveValid(move_id)) move_id = random.GetUInt(6);
-        return move_id;
-      };
-      return EvalGame(ToOrgFun(org), rand_fun, start_player, verbose, os);
+      return PlayGame([this,&org](const MancalaBoard & board){ return EvalMove(board, org); },
+                      [&random](const MancalaBoard & board){ return PickRandomMancalaMove(board, random); },
+                      start_player, verbose, os);
     }
 
     /// Evaluate a game: Organism vs. human opponent.
     /// @param org The organism to be evaluated
     /// @param start_player Which player should make the first move?  (default=0, the organism)
     Results EvalGame(mabe::Organism & org, bool start_player=0) {
-      mancala_ai_t human_fun = [this](emp::Mancala & game){
-        return EvalMove(game, std::cout, std::cin);
-      };
-      return EvalGame(ToOrgFun(org), human_fun, start_player, true);
+      return PlayGame([this,&org](const MancalaBoard & board){ return EvalMove(board, org); },
+                      [this](const MancalaBoard & board){ return EvalMove(board, std::cout, std::cin); },
+                      start_player, true);
     }
 
     /// Trace the evaluation of an organism, sending output to a specified stream.
@@ -225,36 +406,127 @@ namespace mabe {
       EvalGame(org, control.GetRandom(), 0, true, os);
     }
 
-    double Evaluate(const Collection & orgs) {
-      // Determine the type of competitions to perform.
-      // ==> @CAO: For the moment, just doing a random opponent!!
+    /// Run an organism-vs-organism tournament; each round's matches are run in parallel.
+    void RunTournament(const emp::vector<emp::Ptr<Organism>> & players,
+                       const emp::vector<size_t> & hashes, emp::vector<MatchTotals> & totals) {
+      const size_t rounds =
+        (opponent_type == ROUND_ROBIN) ? CountRoundRobinRounds(players.size()) : num_rounds;
+      emp::vector<MatchPair> pairs;
+      emp::vector<GameSlot> slots;
+      std::unordered_map<GameKey, size_t, GameKeyHash> round_games;
+      emp::vector<double> standings(players.size(), 0.0);   // Fitness so far (for Swiss).
+      MatchHistory history(players.size());                 // Past opponents and byes.
+
+      for (size_t round = 0; round < rounds; ++round) {
+        if (opponent_type == ROUND_ROBIN) BuildRoundRobinRound(players.size(), round, pairs);
+        else if (opponent_type == SWISS) {
+          BuildSwissRound(standings, control.GetRandom(), history, pairs);
+        }
+        else BuildRandomRound(players.size(), control.GetRandom(), history, pairs);
+        history.AddRound(pairs);
+
+        // Organisms appear in at most one match per round, so matches can run concurrently.
+        slots.resize(pairs.size() * 2);
+        for (size_t match_id = 0; match_id < pairs.size(); ++match_id) {
+          const MatchPair & pair = pairs[match_id];
+          for (size_t start_player = 0; start_player < 2; ++start_player) {
+            SetupSlot(slots[match_id*2 + start_player], players[pair.player0], hashes[pair.player0],
+                      players[pair.player1], hashes[pair.player1], start_player);
+          }
+        }
+        RunGames(slots, round_games);
+
+        // Combine results in match order.
+        for (size_t match_id = 0; match_id < pairs.size(); ++match_id) {
+          const MatchPair & pair = pairs[match_id];
+          Results results = GetSlotResults(slots, match_id*2);
+          results += GetSlotResults(slots, match_id*2 + 1);
+          totals[pair.player0].Add(results);
+          totals[pair.player1].Add(results.Flip());
+          standings[pair.player0] += results.CalcFitness();
+          standings[pair.player1] += results.Flip().CalcFitness();
+        }
+      }
+    }
 
-      // Loop through the living organisms in the target collection to evaluate each.
+    /// Fraction of cacheable games in the last evaluation that did not need to be played.
+    double GetCacheHitRate() const {
+      return cache_lookups ? ((double) cache_hits) / (double) cache_lookups : 0.0;
+    }
+
+    double Evaluate(const Collection & orgs) {
+      // Gather the living organisms in the target collection.
       mabe::Collection alive_collect( orgs.GetAlive() );
+      emp::vector<emp::Ptr<Organism>> players;
+      for (Organism & org : alive_collect) players.push_back(&org);
 
-      control.Verbose(" - ", alive_collect.GetSize(), " organisms found.");
+      control.Verbose(" - ", players.size(), " organisms found.");
 
-      size_t org_count = 0;
-      double max_fitness = 0.0;
-      for (Organism & org : alive_collect) {
-        control.Verbose("...eval org #", org_count++);
-        double & scoreA = org.GetTrait<double>(scoreA_trait);
-        double & scoreB = org.GetTrait<double>(scoreB_trait);
-        double & num_errors = org.GetTrait<double>(error_trait);
-        double & fitness = org.GetTrait<double>(fitness_trait);
-        Results results = EvalGame(org, control.GetRandom());  // Start first.
-        scoreA = results.scoreA;
-        scoreB = results.scoreB;
-        num_errors = results.num_errors;
-        fitness = results.CalcFitness();
-
-        results = EvalGame(org, control.GetRandom(), 1);  // Start second.
-        scoreA += results.scoreA;
-        scoreB += results.scoreB;
-        num_errors += results.num_errors;
-        fitness += results.CalcFitness();
+      // Genome hashes are only needed if games might be cached.
+      emp::vector<size_t> hashes(players.size(), 0);
+      if (cache_size) {
+        for (size_t org_id = 0; org_id < players.size(); ++org_id) {
+          hashes[org_id] = players[org_id]->GetGenomeHash();
+        }
+      }
+      cache_lookups = cache_hits = 0;
 
-        if (fitness > max_fitness) max_fitness = fitness;
+      if (opponent_type == AI) {
+        if (ai_depth < 1 || ai_depth > MancalaAI::MAX_DEPTH) {
+          emp::notify::Error("EvalMancala ai_depth must be from 1 to ", MancalaAI::MAX_DEPTH,
+                             "; ", ai_depth, " given.");
+          return 0.0;
+        }
+        if (ai_depth != ai.GetDepth()) game_cache.Clear();   // Old games used a different AI.
+        ai.Setup(ai_depth, ai_table_bits);
+      }
+
+      emp::vector<MatchTotals> totals(players.size());
+      if (opponent_type == RANDOM_ORG || opponent_type == ROUND_ROBIN || opponent_type == SWISS) {
+        RunTournament(players, hashes, totals);
+      }
+      else {
+        // Each organism plays its own opponent; seeds are drawn up front so that results do
+        // not depend on which thread runs which match.
+        emp::vector<GameSlot> slots(players.size() * 2);
+        std::unordered_map<GameKey, size_t, GameKeyHash> round_games;
+        for (size_t org_id = 0; org_id < players.size(); ++org_id) {
+          for (size_t start_player = 0; start_player < 2; ++start_player) {
+            GameSlot & slot = slots[org_id*2 + start_player];
+            SetupSlot(slot, players[org_id], hashes[org_id], nullptr, 0, start_player);
+            slot.seed = 1 + (int) control.GetRandom().GetUInt(2147483646);
+          }
+        }
+        RunGames(slots, round_games);
+        for (size_t org_id = 0; org_id < players.size(); ++org_id) {
+          Results results = GetSlotResults(slots, org_id*2);
+          results += GetSlotResults(slots, org_id*2 + 1);
+          totals[org_id].Add(results);
+        }
+      }
+
+      if (cache_size) {
+        control.Verbose(" - game cache: ", cache_hits, " of ", cache_lookups, " games reused (",
+                        game_cache.GetSize(), " stored).");
+      }
+      if (opponent_type == AI) {
+        control.Verbose(" - AI: ", ai.GetMovesReused(), " of ", ai.GetMoves(),
+                        " moves reused; ", ai.GetPositions(), " positions searched (",
+                        ai.GetTableHits(), " resolved by table).");
+      }
+
+      // Record the average results per match on each organism.
+      double max_fitness = 0.0;
+      for (size_t org_id = 0; org_id < players.size(); ++org_id) {
+        Organism & org = *players[org_id];
+        const MatchTotals & org_totals = totals[org_id];
+        const double count = (double) std::max<size_t>(org_totals.num_matches, 1);
+        org.SetTrait<double>(scoreA_trait, org_totals.scoreA / count);
+        org.SetTrait<double>(scoreB_trait, org_totals.scoreB / count);
+        org.SetTrait<double>(error_trait, org_totals.num_errors / count);
+        const double fitness = org_totals.fitness / count;
+        org.SetTrait<double>(fitness_trait, fitness);
+        if (org_id == 0 || fitness > max_fitness) max_fitness = fitness;
       }
 
       return max_fitness;
@@ -10,6 +10,7 @@
 #ifndef MABE_EVAL_COUNT_BITS_H
 #define MABE_EVAL_COUNT_BITS_H
 
+#include "../../core/GenomeView.hpp"
 #include "../../core/MABE.hpp"
 #include "../../core/Module.hpp"
 
@@ -23,6 +24,8 @@ namespace mabe {
     std::string score_trait;
     bool count_type;   // =0 for counts zeros, or =1 for count ones.
 
+    GenomeTraitReader<emp::BitVector> bits_reader;  ///< Access bits as either value or view.
+
   public:
     EvalCountBits(mabe::MABE & control,
                   const std::string & name="EvalCountBits",
@@ -53,8 +56,45 @@ namespace mabe {
     }
 
     void SetupModule() override {
-      AddRequiredTrait<emp::BitVector>(bits_trait);
+      AddRequiredTrait<emp::BitVector, GenomeView<emp::BitVector>>(bits_trait);
       AddOwnedTrait<double>(score_trait, "All-ones score value", 0.0);
+      AddEvaluationTracking();
+    }
+
+    void SetupDataMap(emp::DataMap & dmap) override {
+      bits_reader.Setup(dmap, bits_trait);
+    }
+
+    /// Count the bits in a single organism and store the result in its score trait.  If we know
+    /// which sites have changed since its last evaluation, only those bits are rechecked.
+    bool EvaluateOrg(Organism & org) override {
+      // Make sure this organism has its bit sequence ready for us to access.
+      org.GenerateOutput();
+      const emp::BitVector & bits = bits_reader(org);
+
+      thread_local MutationLog changes;
+      double score = 0.0;
+      if (GetChangesSinceEval(org, changes)) {
+        // Adjust the previous score for each site that flipped.
+        score = org.GetTrait<double>(score_trait);
+        for (size_t i = 0; i < changes.GetSize(); ++i) {
+          const bool was_one = changes.GetOldValue(i) != 0.0;
+          const bool is_one = bits[changes.GetSite(i)];
+          if (was_one != is_one) score += (is_one == count_type) ? 1.0 : -1.0;
+        }
+      }
+      else {
+        // Count the number of ones in the bit sequence.
+        score = (double) bits.CountOnes();
+
+        // If we were supposed to count zeros, subtract ones count from total number of bits.
+        if (count_type == 0) score = bits.size() - score;
+      }
+
+      // Store the count on the organism in the score trait.
+      org.SetTrait<double>(score_trait, score);
+      MarkEvaluated(org);
+      return true;
     }
 
     double Evaluate(Collection orgs) {
@@ -65,18 +105,8 @@ namespace mabe {
       emp::Ptr<Organism> max_org = nullptr;
       mabe::Collection alive_collect( orgs.GetAlive() );
       for (Organism & org : alive_collect) {        
-        // Make sure this organism has its bit sequence ready for us to access.
-        org.GenerateOutput();
-
-        // Count the number of ones in the bit sequence.
-        const emp::BitVector & bits = org.GetTrait<emp::BitVector>(bits_trait);
-        double score = (double) bits.CountOnes();
-
-        // If we were supposed to count zeros, subtract ones count from total number of bits.
-        if (count_type == 0) score = bits.size() - score;
-
-        // Store the count on the organism in the score trait.
-        org.SetTrait<double>(score_trait, score);
+        EvaluateOrg(org);
+        const double score = org.GetTrait<double>(score_trait);
 
         if (score > max_score || !max_org) {
           max_score = score;
@@ -4,14 +4,21 @@
  *  @date 2021.
  *
  *  @file  EvalDiagnostic.hpp
- *  @brief MABE Evaluation module for counting the number of ones (or zeros) in an output.
+ *  @brief MABE Evaluation module for scoring sets of values with a diagnostic problem.
+ *
+ *  With inline_scores set, the scores trait is an InlineTraitVector (up to
+ *  INLINE_TRAIT_CAPACITY values stored inside the organism's DataMap), so cloning an organism
+ *  does not allocate or deep-copy a separate score vector.
  */
 
 #ifndef MABE_EVAL_DIAGNOSTIC_H
 #define MABE_EVAL_DIAGNOSTIC_H
 
+#include "../../core/GenomeView.hpp"
 #include "../../core/MABE.hpp"
 #include "../../core/Module.hpp"
+#include "../../tools/Diagnostics.hpp"
+#include "../../tools/InlineVector.hpp"
 
 namespace mabe {
 
@@ -21,17 +28,10 @@ namespace mabe {
     std::string scores_trait;   // Vector of scores for each value
     std::string total_trait;    // A single value totalling all of the scores.
 
-    enum Type {
-      EXPLOIT,                  // Must drive values as close to 100 as possible.
-      STRUCT_EXPLOIT,           // Start at first value; only count values smaller than previous.
-      EXPLORE,                  // Start at max value; keep counting values if less than previous.
-      DIVERSITY,                // ONLY count max value; all others are max - their current value.
-      WEAK_DIVERSITY,           // ONLY count max value; all others don't count (and can drift)
-      NUM_DIAGNOSTICS,
-      UNKNOWN
-    };
+    DiagnosticType diagnostic_id = DIAG_EXPLOIT;
+    bool inline_scores = false; // Store scores inside the DataMap (limited capacity)?
 
-    Type diagnostic_id;
+    GenomeTraitReader<emp::vector<double>> vals_reader;  // Access values as either copy or view.
 
   public:
     EvalDiagnostic(mabe::MABE & control,
@@ -63,20 +63,41 @@ namespace mabe {
       LinkVar(scores_trait, "scores_trait", "Which trait should we store revised scores in?");
       LinkVar(total_trait, "total_trait", "Which trait should we store the total score in?");
       LinkMenu(diagnostic_id, "diagnostic", "Which Diagnostic should we use?",
-               EXPLOIT, "exploit", "All values must independently optimize to the max.",
-               STRUCT_EXPLOIT, "struct_exploit", "Values must decrease from begining AND optimize.",
-               EXPLORE, "explore", "Only count max value and decreasing values after it.",
-               DIVERSITY, "diversity", "Only count max value; all others must be low.",
-               WEAK_DIVERSITY, "weak_diversity", "Only count max value; all others locked at zero."
+               DIAG_EXPLOIT, "exploit", "All values must independently optimize to the max.",
+               DIAG_STRUCT_EXPLOIT, "struct_exploit", "Values must decrease from begining AND optimize.",
+               DIAG_EXPLORE, "explore", "Only count max value and decreasing values after it.",
+               DIAG_DIVERSITY, "diversity", "Only count max value; all others must be low.",
+               DIAG_WEAK_DIVERSITY, "weak_diversity", "Only count max value; all others locked at zero."
       );
+      LinkVar(inline_scores, "inline_scores",
+              "Store scores inside each organism? (faster copies; at most 128 values)");
     }
 
     void SetupModule() override {
-      AddRequiredTrait<emp::vector<double>>(vals_trait);
-      AddOwnedTrait<emp::vector<double>>(scores_trait, "Individual scores for current diagnostic.", emp::vector<double>({0.0}));
+      AddRequiredTrait<emp::vector<double>, GenomeView<emp::vector<double>>>(vals_trait);
+      if (inline_scores) {
+        AddOwnedTrait<InlineTraitVector<double>>(scores_trait, "Individual scores for current diagnostic.", InlineTraitVector<double>({0.0}));
+      }
+      else {
+        AddOwnedTrait<emp::vector<double>>(scores_trait, "Individual scores for current diagnostic.", emp::vector<double>({0.0}));
+      }
       AddOwnedTrait<double>(total_trait, "Combined score for current diagnostic.", 0.0);
     }
 
+    void SetupDataMap(emp::DataMap & dmap) override {
+      vals_reader.Setup(dmap, vals_trait);
+    }
+
+    /// Score one organism's values into its scores trait (of type SCORES_T); return the total.
+    template <typename SCORES_T>
+    double ScoreOrg(Organism & org, const emp::vector<double> & vals) {
+      SCORES_T & scores = org.GetTrait<SCORES_T>(scores_trait);
+
+      // Score into the existing storage (only resized if the number of values changed).
+      scores.resize(vals.size());
+      return ScoreDiagnostic(diagnostic_id, vals.data(), scores.data(), vals.size());
+    }
+
     double Evaluate(Collection orgs) {
       // Track the organism with the highest total score.
       double max_total = 0.0;
@@ -84,81 +105,30 @@ namespace mabe {
 
       // Loop through the living organisms in the target collection to evaluate each.
       mabe::Collection alive_collect( orgs.GetAlive() );
-      for (Organism & org : alive_collect) {        
-        // Make sure this organism has its values ready for us to access.
-        org.GenerateOutput();
-
-        // Get access to the data_map elements that we need.
-        const emp::vector<double> & vals = org.GetTrait<emp::vector<double>>(vals_trait);
-        emp::vector<double> & scores = org.GetTrait<emp::vector<double>>(scores_trait);
-        double & total_score = org.GetTrait<double>(total_trait);
-
-        // Initialize output values.
-        scores.resize(vals.size());
-        total_score = 0.0;
-        size_t pos = 0;
-
-        // Determine the scores based on the diagnostic type that we're using.
-        switch (diagnostic_id) {
-        case EXPLOIT:
-          scores = vals;
-          for (double x : scores) total_score += x;
-          break;
-        case STRUCT_EXPLOIT:
-          total_score = scores[0] = vals[0];
-
-          // Use values as long as they are monotonically decreasing.
-          for (pos = 1; pos < vals.size() && vals[pos] <= vals[pos-1]; ++pos) {
-            total_score += (scores[pos] = vals[pos]);
-          }
-
-          // Clear out the remaining values.
-          while (pos < scores.size()) { scores[pos] = 0.0; ++pos; }
-          break;
-        case EXPLORE:
-          // Start at highest value (clearing everything before it)
-          pos = emp::FindMaxIndex(vals);  // Find the position to start.
-          for (size_t i = 0; i < pos; i++) scores[i] = 0.0;
-
-          total_score = scores[pos] = vals[pos];
-          pos++;
-
-          // Use values as long as they are monotonically decreasing.
-          while (pos < vals.size() && vals[pos] <= vals[pos-1]) {
-            total_score += (scores[pos] = vals[pos]);
-            pos++;
-          }
 
-          // Clear out the remaining values.
-          while (pos < scores.size()) { scores[pos] = 0.0; ++pos; }
-
-          break;
-        case DIVERSITY:
-          // Only count highest value
-          pos = emp::FindMaxIndex(vals);  // Find the position to start.
-          total_score = scores[pos] = vals[pos];
-
-          // All others are subtracted from max and divided by two, creating a
-          // pressure to minimize.
-          for (size_t i = 0; i < vals.size(); i++) {
-            if (i != pos) total_score += (scores[i] = (vals[pos] - vals[i]) / 2.0);
+      // Make sure all organisms have their values ready for us to access.
+      GenerateOutputs(alive_collect);
+
+      // Inline scores have a fixed capacity; if any organism exceeds it, score none of them.
+      if (inline_scores) {
+        for (Organism & org : alive_collect) {
+          const size_t num_vals = vals_reader(org).size();
+          if (num_vals > INLINE_TRAIT_CAPACITY) {
+            emp::notify::Error("EvalDiagnostic module '", GetName(), "' has ", num_vals,
+                               " values, but inline_scores can hold at most ",
+                               INLINE_TRAIT_CAPACITY, "; no organisms were scored.");
+            return max_total;
           }
+        }
+      }
 
-          break;
-        case WEAK_DIVERSITY:
-          // Only count highest value
-          pos = emp::FindMaxIndex(vals);  // Find the position to start.
-          total_score = scores[pos] = vals[pos];
-
-          // Clear all other schores.
-          for (size_t i = 0; i < vals.size(); i++) {
-            if (i != pos) scores[i] = 0.0;
-          }
+      for (Organism & org : alive_collect) {
+        // Get access to the data_map elements that we need.
+        const emp::vector<double> & vals = vals_reader(org);
+        double & total_score = org.GetTrait<double>(total_trait);
 
-          break;
-        default:
-          emp_error("Unknown Diganostic.");
-        }
+        if (inline_scores) total_score = ScoreOrg<InlineTraitVector<double>>(org, vals);
+        else total_score = ScoreOrg<emp::vector<double>>(org, vals);
 
         if (total_score > max_total || !max_org) {
           max_total = total_score;
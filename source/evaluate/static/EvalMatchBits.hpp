@@ -14,6 +14,7 @@
 #ifndef MABE_EVAL_MATCH_BITS_H
 #define MABE_EVAL_MATCH_BITS_H
 
+#include "../../core/GenomeView.hpp"
 #include "../../core/MABE.hpp"
 #include "../../core/Module.hpp"
 
@@ -35,6 +36,8 @@ namespace mabe {
     bool record_both = false;             // Save result on both organisms? (vs. first only)
     double empty_score = 0.0;             // Score to give orgs matched with empty positions.
 
+    GenomeTraitReader<emp::BitVector> bits_reader;  // Access bits as either value or view.
+
   public:
     EvalMatchBits(mabe::MABE & control,
                   const std::string & name="EvalMatchBits",
@@ -65,10 +68,14 @@ namespace mabe {
     }
 
     void SetupModule() override {
-      AddRequiredTrait<emp::BitVector>(bits_trait);
+      AddRequiredTrait<emp::BitVector, GenomeView<emp::BitVector>>(bits_trait);
       AddOwnedTrait<double>(score_trait, "Match score value", 0.0);
     }
 
+    void SetupDataMap(emp::DataMap & dmap) override {
+      bits_reader.Setup(dmap, bits_trait);
+    }
+
     double EvaluateMatch(Organism & org1, Organism & org2) {      
       double match_score = empty_score;
 
@@ -78,8 +85,8 @@ namespace mabe {
         org1.GenerateOutput();
         org2.GenerateOutput();
 
-        const emp::BitVector & bits1 = org1.GetTrait<emp::BitVector>(bits_trait);
-        const emp::BitVector & bits2 = org2.GetTrait<emp::BitVector>(bits_trait);
+        const emp::BitVector & bits1 = bits_reader(org1);
+        const emp::BitVector & bits2 = bits_reader(org2);
         org1.SetTrait<double>(score_trait, match_score);
 
         // Count the number of matches in the bit sequences.
@@ -10,23 +10,74 @@
 #ifndef MABE_EVAL_NK_H
 #define MABE_EVAL_NK_H
 
+#include <algorithm>
+
+#include "../../core/GenomeView.hpp"
 #include "../../core/MABE.hpp"
 #include "../../core/Module.hpp"
+#include "../../tools/NK-const.hpp"
 #include "../../tools/NK.hpp"
 
 #include "emp/datastructs/reference_vector.hpp"
 
 namespace mabe {
 
+  /// Common interface for compile-time NK landscapes, so EvalNK can pick one at runtime.
+  class NKStaticBase {
+  public:
+    virtual ~NKStaticBase() { }
+    virtual void Load(const NKLandscape & in) = 0;  ///< Copy all fitness values from in.
+    virtual double GetFitness(const emp::BitVector & genome) const = 0;
+  };
+
+  template <size_t N, size_t K>
+  class NKStatic : public NKStaticBase {
+  private:
+    emp::evo::NKLandscapeConst<N,K> landscape;
+
+  public:
+    void Load(const NKLandscape & in) override {
+      emp_assert(in.GetN() == N && in.GetK() == K);
+      for (size_t n = 0; n < N; n++) {
+        for (size_t state = 0; state < landscape.GetStateCount(); state++) {
+          landscape.SetState(n, state, in.GetFitness(n, state));
+        }
+      }
+    }
+    double GetFitness(const emp::BitVector & genome) const override {
+      return landscape.GetFitness(genome);
+    }
+  };
+
+  template <size_t _N, size_t _K> struct NKSize { static constexpr size_t N = _N, K = _K; };
+
+  /// Build the compile-time landscape from SIZE_Ts that matches N and K (or nullptr if none do).
+  template <typename... SIZE_Ts>
+  emp::Ptr<NKStaticBase> BuildNKStatic(size_t N, size_t K) {
+    emp::Ptr<NKStaticBase> out = nullptr;
+    ((out.IsNull() && N == SIZE_Ts::N && K == SIZE_Ts::K
+      && (out = emp::NewPtr<NKStatic<SIZE_Ts::N, SIZE_Ts::K>>(), true)), ...);
+    return out;
+  }
+
   class EvalNK : public Module {
   private:
     size_t N;
     size_t K;    
+    bool use_float = false;   ///< Store landscape tables in single precision?
+    bool use_static = true;   ///< Use a compile-time landscape when one matches N and K?
+    bool incremental = false; ///< Rescore only genes affected by mutations since last evaluation?
+    bool use_cache = false;   ///< Generate gene values on demand instead of storing full tables?
+    size_t cache_bits = 20;   ///< With use_cache, remember up to 2^cache_bits gene values.
     NKLandscape landscape;
+    NKLandscapeCached cached_landscape;  ///< Used instead of landscape if use_cache is set.
+    emp::Ptr<NKStaticBase> static_landscape = nullptr;  ///< Faster copy of landscape (if any).
 
     std::string bits_trait;
     std::string fitness_trait;
 
+    GenomeTraitReader<emp::BitVector> bits_reader;  ///< Access bits as either value or view.
+
   public:
     EvalNK(mabe::MABE & control,
            const std::string & name="EvalNK",
@@ -39,7 +90,30 @@ namespace mabe {
     {
       SetEvaluateMod(true);
     }
-    ~EvalNK() { }
+    ~EvalNK() { if (static_landscape) static_landscape.Delete(); }
+
+    /// Sizes with compile-time landscapes (add to this list to speed up other common sizes).
+    static emp::Ptr<NKStaticBase> BuildStatic(size_t N, size_t K) {
+      return BuildNKStatic<NKSize<20,3>, NKSize<50,3>, NKSize<100,1>, NKSize<100,2>,
+                           NKSize<100,3>, NKSize<100,4>, NKSize<100,8>, NKSize<1000,8>>(N, K);
+    }
+
+    /// Build a new landscape with the current N and K (and matching static copy if available).
+    /// Fitness values from the old landscape cannot be updated incrementally, so every organism
+    /// gets a full evaluation next time.
+    void ResetLandscape() {
+      InvalidateEvaluations();
+      if (static_landscape) static_landscape.Delete();
+      static_landscape = nullptr;
+      if (use_cache) {
+        landscape = NKLandscape();
+        cached_landscape.Config(N, K, control.GetRandom(), cache_bits);
+        return;
+      }
+      landscape.Config(N, K, control.GetRandom(), use_float);
+      if (use_static && !use_float) static_landscape = BuildStatic(N, K);
+      if (static_landscape) static_landscape->Load(landscape);
+    }
 
     // Setup member functions associated with this class.
     static void InitType(emplode::TypeInfo & info) {
@@ -47,24 +121,100 @@ namespace mabe {
                              [](EvalNK & mod, Collection list) { return mod.Evaluate(list); },
                              "Use NK landscape to evaluate all orgs in an OrgList.");
       info.AddMemberFunction("RESET",
-                             [](EvalNK & mod) { mod.landscape.Config(mod.N, mod.K, mod.control.GetRandom()); return 0; },
+                             [](EvalNK & mod) { mod.ResetLandscape(); return 0; },
                              "Regenerate the NK landscape with current N and K.");
     }
 
     void SetupConfig() override {
       LinkVar(N, "N", "Number of bits required in output");
       LinkVar(K, "K", "Number of bits used in each gene");
+      LinkVar(use_float, "use_float", "Store landscape in single precision (halves memory for large K)?");
+      LinkVar(use_static, "use_static", "Use a faster compile-time landscape if one matches N and K?");
+      LinkVar(incremental, "incremental", "Rescore only genes affected by new mutations? (faster; rounding error can accumulate)");
+      LinkVar(use_cache, "use_cache", "Generate gene values on demand rather than storing tables? (for large K)");
+      LinkVar(cache_bits, "cache_bits", "With use_cache, remember up to 2^cache_bits gene values.");
       LinkVar(bits_trait, "bits_trait", "Which trait stores the bit sequence to evaluate?");
       LinkVar(fitness_trait, "fitness_trait", "Which trait should we store NK fitness in?");
     }
 
     void SetupModule() override {
       // Setup the traits.
-      AddRequiredTrait<emp::BitVector>(bits_trait);
+      AddRequiredTrait<emp::BitVector, GenomeView<emp::BitVector>>(bits_trait);
       AddOwnedTrait<double>(fitness_trait, "NK fitness value", 0.0);
+      AddEvaluationTracking();
 
       // Setup the fitness landscape.
-      landscape.Config(N, K, control.GetRandom());  // Setup the fitness landscape.
+      ResetLandscape();  // Setup the fitness landscape.
+    }
+
+    void SetupDataMap(emp::DataMap & dmap) override {
+      bits_reader.Setup(dmap, bits_trait);
+    }
+
+    /// Fitness contribution of a single gene in a given state, from whichever landscape is in use.
+    double GetGeneFitness(size_t gene, size_t state) const {
+      return use_cache ? cached_landscape.GetFitness(gene, state) : landscape.GetFitness(gene, state);
+    }
+
+    /// Calculate how much fitness has changed due to the listed sites (sorted, with their old
+    /// values) taking on their current values in bits; only genes that use those sites are
+    /// rescored (K+1 per site).
+    double CalcFitnessChange(const emp::BitVector & bits, const MutationLog & changes) const {
+      // Find every gene whose window includes a changed site.
+      thread_local emp::vector<size_t> genes;
+      genes.resize(0);
+      for (size_t i = 0; i < changes.GetSize(); ++i) {
+        const size_t site = changes.GetSite(i);
+        for (size_t k = 0; k <= K; ++k) genes.push_back(site >= k ? site - k : site + N - k);
+      }
+      std::sort(genes.begin(), genes.end());
+      genes.erase(std::unique(genes.begin(), genes.end()), genes.end());
+
+      double delta = 0.0;
+      for (size_t gene : genes) {
+        // Rebuild the old state from the current one by restoring any changed sites in window.
+        const size_t new_state = use_cache ? cached_landscape.GetState(bits, gene)
+                                           : landscape.GetState(bits, gene);
+        size_t old_state = new_state;
+        for (size_t i = 0; i < changes.GetSize(); ++i) {
+          const size_t site = changes.GetSite(i);
+          const size_t offset = (site >= gene) ? (site - gene) : (site + N - gene);
+          if (offset > K) continue;
+          const size_t bit = ((size_t) 1) << offset;
+          if (changes.GetOldValue(i) != 0.0) old_state |= bit;
+          else old_state &= ~bit;
+        }
+        if (old_state == new_state) continue;
+        delta += GetGeneFitness(gene, new_state) - GetGeneFitness(gene, old_state);
+      }
+      return delta;
+    }
+
+    /// Evaluate a single organism on the NK landscape, storing its fitness trait.  If only a
+    /// few sites have changed since its last evaluation, only the genes using them are rescored.
+    bool EvaluateOrg(Organism & org) override {
+      org.GenerateOutput();
+      const auto & bits = bits_reader(org);
+      if (bits.size() != N) {
+        emp::notify::Error("Org returns ", bits.size(), " bits, but ",
+                           N, " bits needed for NK landscape.",
+                           "\nOrg: ", org.ToString());
+        return false;
+      }
+
+      thread_local MutationLog changes;
+      double fitness = 0.0;
+      if (incremental && GetChangesSinceEval(org, changes) && changes.GetSize() * (K+1) < N) {
+        fitness = org.GetTrait<double>(fitness_trait) + CalcFitnessChange(bits, changes);
+      }
+      else {
+        if (static_landscape) fitness = static_landscape->GetFitness(bits);
+        else if (use_cache) fitness = cached_landscape.GetFitness(bits);
+        else fitness = landscape.GetFitness(bits);
+      }
+      org.SetTrait<double>(fitness_trait, fitness);
+      MarkEvaluated(org);
+      return true;
     }
 
     double Evaluate(const Collection & orgs) {
@@ -73,15 +223,8 @@ namespace mabe {
       emp::Ptr<Organism> max_org = nullptr;
       mabe::Collection alive_orgs( orgs.GetAlive() );
       for (Organism & org : alive_orgs) {
-        org.GenerateOutput();
-        const auto & bits = org.GetTrait<emp::BitVector>(bits_trait);
-        if (bits.size() != N) {
-          emp::notify::Error("Org returns ", bits.size(), " bits, but ",
-                             N, " bits needed for NK landscape.",
-                             "\nOrg: ", org.ToString());
-        }
-        double fitness = landscape.GetFitness(bits);
-        org.SetTrait<double>(fitness_trait, fitness);
+        if (!EvaluateOrg(org)) break;  // Error already reported; fitness trait is not valid.
+        const double fitness = org.GetTrait<double>(fitness_trait);
 
         if (fitness > max_fitness || !max_org) {
           max_fitness = fitness;
@@ -13,6 +13,7 @@
 #ifndef MABE_EVAL_ROYAL_ROAD_H
 #define MABE_EVAL_ROYAL_ROAD_H
 
+#include "../../core/GenomeView.hpp"
 #include "../../core/MABE.hpp"
 #include "../../core/Module.hpp"
 
@@ -28,6 +29,8 @@ namespace mabe {
     size_t brick_size = 8;
     double extra_bit_cost = 0.5;
 
+    GenomeTraitReader<emp::BitVector> bits_reader;  ///< Access bits as either value or view.
+
   public:
     EvalRoyalRoad(mabe::MABE & control,
                   const std::string & name="EvalRoyalRoad",
@@ -55,10 +58,14 @@ namespace mabe {
     }
 
     void SetupModule() override {
-      AddRequiredTrait<emp::BitVector>(bits_trait);
+      AddRequiredTrait<emp::BitVector, GenomeView<emp::BitVector>>(bits_trait);
       AddOwnedTrait<double>(score_trait, "Royal Road score value", 0.0);
     }
 
+    void SetupDataMap(emp::DataMap & dmap) override {
+      bits_reader.Setup(dmap, bits_trait);
+    }
+
     double Evaluate(Collection orgs) {
       // Loop through the population and evaluate each organism.
       double max_score = 0.0;
@@ -68,7 +75,7 @@ namespace mabe {
         org.GenerateOutput();
 
         // Count the number of ones in the bit sequence.
-        const emp::BitVector & bits = org.GetTrait<emp::BitVector>(bits_trait);
+        const emp::BitVector & bits = bits_reader(org);
         int road_length = 0.0;
         for (size_t i = 0; i < bits.size(); i++) {
           if (bits[i] == 0) break;
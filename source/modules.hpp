@@ -17,6 +17,9 @@
 
 // Interface Modules
 
+// Mutation Modules
+#include "mutate/LocalSearch.hpp"
+
 // Placement Modules
 
 // Selection Modules
@@ -28,4 +31,7 @@
 // Organism Types
 #include "orgs/AvidaGPOrg.hpp"
 #include "orgs/BitsOrg.hpp"
+#include "orgs/FixedBitsOrg.hpp"
+#include "orgs/NeuralNetOrg.hpp"
+#include "orgs/SimpleProgramOrg.hpp"
 #include "orgs/ValsOrg.hpp"
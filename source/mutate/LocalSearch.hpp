@@ -0,0 +1,116 @@
+/**
+ *  @note This file is part of MABE, https://github.com/mercere99/MABE2
+ *  @copyright Copyright (C) Michigan State University, MIT Software license; see doc/LICENSE.md
+ *  @date 2021.
+ *
+ *  @file  LocalSearch.hpp
+ *  @brief MABE module to refine organisms in place with hill-climbing.
+ *
+ *  Each refinement step mutates an organism in place (recording what changed), asks the
+ *  evaluation module to rescore it, and then reverts the mutations (and rescores) if the score
+ *  got worse.  Evaluation modules that track mutation histories only rescore changed sites.
+ *  No organisms are copied, so a step costs time proportional to the number of mutations
+ *  rather than to the size of the organism.
+ *
+ *  The organism type must support MutateWithUndo() and RevertMutations(), and the evaluation
+ *  module must support EvaluateOrg().
+ */
+
+#ifndef MABE_LOCAL_SEARCH_H
+#define MABE_LOCAL_SEARCH_H
+
+#include "../core/MABE.hpp"
+#include "../core/Module.hpp"
+#include "../core/MutationLog.hpp"
+
+namespace mabe {
+
+  /// Hill-climb each organism in a collection by in-place mutation with undo.
+  class LocalSearch : public Module {
+  private:
+    int eval_module_id = -1;          ///< ID of module used to score organisms.
+    std::string score_trait = "fitness";  ///< Which trait holds the score to maximize?
+    size_t num_steps = 10;            ///< How many mutations should be tried on each organism?
+    bool accept_equal = true;         ///< Should neutral mutations be kept?
+
+    MutationLog mut_log;              ///< Changes from the current step (reused between steps).
+
+    /// Run local search on each living organism in a collection; return the number of
+    /// mutation steps that were kept.
+    double Refine(const Collection & orgs) {
+      if (eval_module_id < 0) {
+        emp::notify::Error("LocalSearch module '", GetName(), "' has no evaluation module set.");
+        return 0.0;
+      }
+      ModuleBase & eval_mod = control.GetModule(eval_module_id);
+      emp::Random & random = control.GetRandom();
+      size_t num_kept = 0;
+      mabe::Collection alive_orgs( orgs.GetAlive() );
+      for (Organism & org : alive_orgs) {
+        // Make sure we are starting from an accurate score.
+        if (!eval_mod.EvaluateOrg(org)) {
+          emp::notify::Error("LocalSearch module '", GetName(), "' requires evaluation module '",
+                             eval_mod.GetName(), "' to support evaluating single organisms.");
+          return (double) num_kept;
+        }
+        double score = org.GetTrait<double>(score_trait);
+
+        for (size_t step = 0; step < num_steps; ++step) {
+          const size_t num_muts = org.MutateWithUndo(random, mut_log);
+          if (!mut_log.CanUndo()) {
+            emp::notify::Error("LocalSearch module '", GetName(),
+                               "' requires organisms that can revert mutations.");
+            return (double) num_kept;
+          }
+          if (num_muts == 0) continue;
+
+          eval_mod.EvaluateOrg(org);
+          const double new_score = org.GetTrait<double>(score_trait);
+          if (new_score > score || (accept_equal && new_score == score)) {
+            score = new_score;
+            ++num_kept;
+          }
+          else {
+            org.RevertMutations(mut_log);
+            eval_mod.EvaluateOrg(org);
+          }
+        }
+      }
+
+      return (double) num_kept;
+    }
+
+  public:
+    LocalSearch(mabe::MABE & control,
+                const std::string & name="LocalSearch",
+                const std::string & desc="Module to hill-climb organisms by in-place mutation.",
+                const std::string & _strait="fitness")
+      : Module(control, name, desc), score_trait(_strait)
+    {
+      SetMutateMod(true);         ///< Mark this module as a mutation module.
+    }
+    ~LocalSearch() { }
+
+    // Setup member functions associated with this class.
+    static void InitType(emplode::TypeInfo & info) {
+      info.AddMemberFunction("REFINE",
+                             [](LocalSearch & mod, Collection list) { return mod.Refine(list); },
+                             "Hill-climb all orgs in an OrgList; return number of steps kept.");
+    }
+
+    void SetupConfig() override {
+      LinkModule(eval_module_id, "eval_module", "Which evaluation module should score organisms?");
+      LinkVar(score_trait, "score_trait", "Which trait holds the score to maximize?");
+      LinkVar(num_steps, "num_steps", "Number of mutation steps to try on each organism.");
+      LinkVar(accept_equal, "accept_equal", "Should mutations that keep the same score be kept?");
+    }
+
+    void SetupModule() override {
+      AddRequiredTrait<double>(score_trait);  // The score must be set by the evaluation module.
+    }
+  };
+
+  MABE_REGISTER_MODULE(LocalSearch, "Hill-climb organisms by in-place mutation with undo.");
+}
+
+#endif
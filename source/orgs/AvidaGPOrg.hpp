@@ -6,14 +6,32 @@
  *  @file  AvidaGPOrg.hpp
  *  @brief An organism consisting of lineaer code.
  *  @note Status: ALPHA
+ *
+ *  Each organism stores only a compact genome (4 bytes per instruction).  The hardware needed
+ *  to run it is held in an execution context that belongs to the current thread and is borrowed
+ *  during GenerateOutput(); the genome is only re-loaded when a different genome was last run
+ *  in that context.  Setting persistent_state gives each organism its own context instead, so
+ *  CPU state carries over between executions (and ProcessStep() advances it one cycle at a time).
+ *
+ *  Genomes are stored in copy-on-write chunks, so an offspring shares its parent's memory and
+ *  only copies the chunks that its mutations touch.  Insertion and deletion mutations (ins_prob
+ *  and del_prob) only shift instructions within a single chunk; the genome is linearized when
+ *  it needs to be loaded or compiled.
  */
 
 #ifndef MABE_AVIDA_GP_ORGANISM_H
 #define MABE_AVIDA_GP_ORGANISM_H
 
+#include <cstdint>
+#include <sstream>
+
 #include "../core/MABE.hpp"
 #include "../core/Organism.hpp"
 #include "../core/OrganismManager.hpp"
+#include "../tools/CompiledAvidaGP.hpp"
+#include "../tools/CopyOnWrite.hpp"
+#include "../tools/SkipSampler.hpp"
+#include "../tools/StreamHash.hpp"
 
 #include "emp/datastructs/vector_utils.hpp"
 #include "emp/hardware/AvidaGP.hpp"
@@ -23,15 +41,136 @@
 namespace mabe {
 
   class AvidaGPOrg : public OrganismTemplate<AvidaGPOrg> {
+  public:
+    using inst_lib_t = emp::AvidaGP::inst_lib_t;
+
+    /// Compact representation of a single instruction in the genome.
+    struct Inst {
+      uint8_t id = 0;
+      uint8_t args[3] = {0, 0, 0};
+
+      bool operator==(const Inst & in) const {
+        return id == in.id && args[0] == in.args[0] && args[1] == in.args[1] && args[2] == in.args[2];
+      }
+    };
+    using genome_t = SharedChunkVector<Inst, 64>;
+
+    /// Everything needed to execute a genome; only used while an organism is running, so it is
+    /// normally borrowed from the current thread rather than stored in each organism.
+    struct ExecContext {
+      emp::AvidaGP hardware;          ///< Standard hardware for running a genome.
+      CompiledAvidaGP::State state;   ///< CPU state for the pre-decoded interpreter.
+      size_t loaded_id = 0;           ///< ID of genome currently loaded into hardware (0 = none)
+    };
+
   protected:
-    emp::AvidaGP hardware;
+    genome_t genome;                   ///< Sequence of instructions making up this organism.
+    size_t genome_id = 0;              ///< Unique ID for this genome sequence (shared by clones)
+    CompiledAvidaGP program;           ///< Pre-decoded version of genome (used if fast_exec is set)
+    emp::Ptr<ExecContext> own_context; ///< Private context; only used with persistent_state.
+
+    /// Provide a new ID whenever a genome changes, so cached copies can be identified.
+    static size_t NextGenomeID() {
+      static size_t next_id = 0;
+      return ++next_id;
+    }
+
+    /// Note that the genome has changed, so any cached versions of it are out of date.
+    void GenomeChanged() {
+      genome_id = NextGenomeID();
+      program.Invalidate();
+    }
+
+    /// Scratch execution context shared by all organisms run on the current thread.
+    static ExecContext & GetThreadContext() {
+      thread_local ExecContext context;
+      return context;
+    }
+
+    /// Context owned by this organism, for when CPU state must persist between executions.
+    ExecContext & GetOwnContext() {
+      if (!own_context) own_context = emp::NewPtr<ExecContext>();
+      return *own_context;
+    }
+
+    ExecContext & GetContext() {
+      return SharedData().persistent_state ? GetOwnContext() : GetThreadContext();
+    }
+
+    /// Make sure the hardware in the provided context is running this organism's genome.
+    emp::AvidaGP & LoadHardware(ExecContext & context) const {
+      emp::AvidaGP & hw = context.hardware;
+      if (context.loaded_id != genome_id) {
+        hw.Reset();
+        genome.ForEachChunk([&hw](const Inst * insts, size_t count){
+          for (size_t i = 0; i < count; ++i) {
+            hw.PushInst(insts[i].id, insts[i].args[0], insts[i].args[1], insts[i].args[2]);
+          }
+        });
+        context.loaded_id = genome_id;
+      }
+      return hw;
+    }
+
+    /// Make sure the pre-decoded program is up to date; return false if it cannot be compiled.
+    bool CompileProgram() {
+      auto & data = SharedData();
+      if (program.IsCompiled()) return true;
+      thread_local emp::vector<Inst> linear_genome;
+      genome.CopyTo(linear_genome);
+      return program.Compile(linear_genome, data.op_map, data.strip_introns);
+    }
+
+    /// Should we use the pre-decoded interpreter?  (Compile the genome if needed.)
+    bool UseFastExec() { return SharedData().fast_exec && CompileProgram(); }
+
+    void RandomizeInst(Inst & inst, emp::Random & random) const {
+      inst.id = (uint8_t) random.GetUInt(SharedData().inst_lib->GetSize());
+      for (uint8_t & arg : inst.args) arg = (uint8_t) random.GetUInt(CompiledAvidaGP::CPU_SIZE);
+    }
+
+    /// Insert and delete instructions (each site independently), staying within length limits.
+    size_t MutateLength(emp::Random & random) {
+      auto & data = SharedData();
+      size_t num_muts = 0;
+
+      // Deletions: after removing a site, the next candidate is already at the same position.
+      if (data.del_prob > 0.0) {
+        for (size_t pos = data.del_skips.NextSkip(random, genome.size());
+             pos < genome.size() && genome.size() > data.min_length;
+             pos += data.del_skips.NextSkip(random, genome.size())) {
+          genome.Erase(pos);
+          ++num_muts;
+        }
+      }
+
+      // Insertions: add a random instruction before the chosen site, then move past it.
+      if (data.ins_prob > 0.0) {
+        for (size_t pos = data.ins_skips.NextSkip(random, genome.size());
+             pos < genome.size() && genome.size() < data.max_length;
+             pos += data.ins_skips.NextSkip(random, genome.size()) + 2) {
+          Inst inst;
+          RandomizeInst(inst, random);
+          genome.Insert(pos, inst);
+          ++num_muts;
+        }
+      }
+
+      return num_muts;
+    }
 
   public:
     AvidaGPOrg(OrganismManager<AvidaGPOrg> & _manager)
-      : OrganismTemplate<AvidaGPOrg>(_manager) { }
-    AvidaGPOrg(const AvidaGPOrg &) = default;
-    AvidaGPOrg(AvidaGPOrg &&) = default;
-    ~AvidaGPOrg() { ; }
+      : OrganismTemplate<AvidaGPOrg>(_manager), genome_id(NextGenomeID()) { }
+    AvidaGPOrg(const AvidaGPOrg & in)   // Execution state is NOT copied.
+      : OrganismTemplate<AvidaGPOrg>(in)
+      , genome(in.genome), genome_id(in.genome_id), program(in.program) { }
+    AvidaGPOrg(AvidaGPOrg && in)
+      : OrganismTemplate<AvidaGPOrg>(in)
+      , genome(std::move(in.genome)), genome_id(in.genome_id), program(std::move(in.program))
+      , own_context(in.own_context)
+    { in.own_context = nullptr; }
+    ~AvidaGPOrg() { if (own_context) own_context.Delete(); }
 
     struct ManagerData : public Organism::ManagerData {
       // Configuration variables
@@ -41,22 +180,90 @@ namespace mabe {
       size_t eval_time = 500;              ///< How long should the CPU be given on each evaluate?
       std::string input_name = "input";    ///< Name of trait that should be used load input values
       std::string output_name = "output";  ///< Name of trait that should be used store output values
+      bool fast_exec = false;              ///< Run genomes with the pre-decoded interpreter?
+      bool persistent_state = false;       ///< Should each organism keep its own CPU state?
+      bool strip_introns = true;           ///< Skip instructions that cannot affect outputs?
+      double ins_prob = 0.0;               ///< Probability of an insertion at each site.
+      double del_prob = 0.0;               ///< Probability of each site being deleted.
+      size_t min_length = 1;               ///< Deletions cannot shrink genomes below this.
+      size_t max_length = 1000;            ///< Insertions cannot grow genomes beyond this.
+      std::string effective_name = "";     ///< Trait for # of effective insts ("" for none)
 
       // Internal use
       emp::Binomial mut_dist;            ///< Distribution of number of mutations to occur.
       emp::BitVector mut_sites;            ///< A pre-allocated vector for mutation sites. 
+      CompiledAvidaGP::OpMap op_map;       ///< Instruction IDs to opcodes (read-only once set up)
+      emp::Ptr<const inst_lib_t> inst_lib = emp::AvidaGP().GetInstLib();  ///< Instruction set
+      SkipSampler mut_skips;               ///< Distance between point mutations (from mut_prob).
+      SkipSampler ins_skips;               ///< Distance between insertions (from ins_prob).
+      SkipSampler del_skips;               ///< Distance between deletions (from del_prob).
     };
 
-    /// Use "to_string" to convert.
-    std::string ToString() const override { return hardware.ToString(); }
+    size_t GetGenomeSize() const { return genome.size(); }
+    const genome_t & GetGenome() const { return genome; }
+
+    /// Hash the instruction sequence (unless CPU state persists between executions, in which
+    /// case behavior depends on more than the genome).
+    size_t GetGenomeHash() const override {
+      if (SharedData().persistent_state) return 0;
+      StreamHash hash(genome.size());
+      genome.ForEachChunk([&hash](const Inst * insts, size_t count){
+        for (size_t i = 0; i < count; ++i) {
+          const Inst & inst = insts[i];
+          hash.Add(inst.id | ((uint64_t) inst.args[0] << 8) | ((uint64_t) inst.args[1] << 16)
+                   | ((uint64_t) inst.args[2] << 24));
+        }
+      });
+      return hash.Get();
+    }
+
+    /// Convert the genome to a string: instruction names with their arguments.
+    std::string ToString() const override {
+      const inst_lib_t & inst_lib = *SharedData().inst_lib;
+      std::stringstream ss;
+      for (size_t pos = 0; pos < genome.size(); ++pos) {
+        const Inst & inst = genome[pos];
+        if (pos) ss << "; ";
+        ss << inst_lib.GetName(inst.id) << " " << (size_t) inst.args[0] << " "
+           << (size_t) inst.args[1] << " " << (size_t) inst.args[2];
+      }
+      return ss.str();
+    }
 
     size_t Mutate(emp::Random & random) override {
-      const size_t num_muts = SharedData().mut_dist.PickRandom(random);
+      size_t num_length_muts = 0;
+      if (SharedData().ins_prob > 0.0 || SharedData().del_prob > 0.0) {
+        num_length_muts = MutateLength(random);
+        if (num_length_muts) GenomeChanged();
+      }
+      return num_length_muts + MutatePoints(random);
+    }
+
+    /// Point mutations: randomize individual instructions.
+    size_t MutatePoints(emp::Random & random) {
+      auto & data = SharedData();
+
+      // If genome lengths can change, the pre-built distribution may be the wrong size.
+      if (genome.size() != data.mut_sites.size()) {
+        if (data.mut_prob <= 0.0) return 0;
+        const size_t N = genome.size();
+        size_t num_muts = 0;
+        for (size_t pos = data.mut_skips.NextSkip(random, N); pos < N;
+             pos += data.mut_skips.NextSkip(random, N) + 1) {
+          RandomizeInst(genome.Edit(pos), random);
+          ++num_muts;
+        }
+        if (num_muts) GenomeChanged();
+        return num_muts;
+      }
+
+      const size_t num_muts = data.mut_dist.PickRandom(random);
 
       if (num_muts == 0) return 0;
+      GenomeChanged();
       if (num_muts == 1) {
-        const size_t pos = random.GetUInt(hardware.GetSize());
-        hardware.RandomizeInst(pos, random);
+        const size_t pos = random.GetUInt(genome.size());
+        RandomizeInst(genome.Edit(pos), random);
         return 1;
       }
 
@@ -64,18 +271,18 @@ namespace mabe {
       auto & mut_sites = SharedData().mut_sites;
       mut_sites.Clear();
       for (size_t i = 0; i < num_muts; i++) {
-        const size_t pos = random.GetUInt(hardware.GetSize());
+        const size_t pos = random.GetUInt(genome.size());
         if (mut_sites[pos]) { --i; continue; }  // Duplicate position; try again.
-        hardware.RandomizeInst(pos, random);
+        mut_sites.Set(pos);
+        RandomizeInst(genome.Edit(pos), random);
       }
 
       return num_muts;
     }
 
     void Randomize(emp::Random & random) override {
-      for (size_t pos = 0; pos < hardware.GetSize(); pos++) {
-        hardware.RandomizeInst(pos, random);
-      }
+      GenomeChanged();
+      for (size_t pos = 0; pos < genome.size(); ++pos) RandomizeInst(genome.Edit(pos), random);
     }
 
     void Initialize(emp::Random & random) override {
@@ -84,24 +291,83 @@ namespace mabe {
 
     /// Put the output values in the correct output position.
     void GenerateOutput() override {
-      hardware.ResetHardware();
+      auto & data = SharedData();
+      ExecContext & context = GetContext();
+      const emp::vector<double> & inputs = GetTrait<emp::vector<double>>(data.input_name);
+      emp::vector<double> & outputs = GetTrait<emp::vector<double>>(data.output_name);
+
+      if (data.effective_name.size() && CompileProgram()) {
+        SetTrait<double>(data.effective_name, (double) program.GetEffectiveSize());
+      }
+
+      // If we can use the pre-decoded program, do so (compiling it first if needed).
+      if (UseFastExec()) {
+        CompiledAvidaGP::State & state = context.state;
+        if (!data.persistent_state) state.Reset();
+        state.SetInputs(inputs);
+        program.Process(state, data.eval_time);
+        state.CopyOutputs(outputs);
+        return;
+      }
+
+      emp::AvidaGP & hardware = LoadHardware(context);
+      if (!data.persistent_state) hardware.ResetHardware();
 
       // Setup the input.
-      hardware.SetInputs(GetTrait<emp::vector<double>>(SharedData().input_name));
+      hardware.SetInputs(inputs);
 
       // Run the code.
-      hardware.Process(SharedData().eval_time);
+      hardware.Process(data.eval_time);
 
       // Store the results.
-      SetTrait<emp::vector<double>>(SharedData().output_name, emp::ToVector(hardware.GetOutputs()));
+      outputs = emp::ToVector(hardware.GetOutputs());
+    }
+
+    /// With persistent state, advance this organism's own CPU by a single cycle.
+    bool ProcessStep() override {
+      if (!SharedData().persistent_state) return false;
+      ExecContext & context = GetOwnContext();
+      if (UseFastExec()) program.Process(context.state, 1);
+      else LoadHardware(context).Process(1);
+      return true;
+    }
+
+    /// Evaluate many input cases in a row, writing outputs into a case-by-output matrix.
+    /// Each case starts from a reset CPU, so the thread's scratch context is always used.
+    bool GenerateOutputBatch(const emp::vector<emp::vector<double>> & inputs,
+                             emp::vector<double> & outputs,
+                             size_t num_outputs) override {
+      auto & data = SharedData();
+      ExecContext & context = GetThreadContext();
+      outputs.resize(inputs.size() * num_outputs);
+
+      if (UseFastExec()) {
+        program.RunBatch(context.state, inputs, data.eval_time, outputs.data(), num_outputs);
+        return true;
+      }
+
+      // Otherwise use the standard hardware, reading outputs directly rather than copying them.
+      emp::AvidaGP & hardware = LoadHardware(context);
+      size_t out_pos = 0;
+      for (const emp::vector<double> & case_inputs : inputs) {
+        hardware.ResetHardware();
+        hardware.SetInputs(case_inputs);
+        hardware.Process(data.eval_time);
+        for (size_t i = 0; i < num_outputs; ++i) outputs[out_pos++] = hardware.GetOutput((int) i);
+      }
+      return true;
+    }
+
+    std::string GetSharingStats() const override {
+      return emp::to_string("Genome chunks: ", genome_t::GetStats().ToString("chunks"));
     }
 
     /// Setup this organism type to be able to load from config.
     void SetupConfig() override {
       GetManager().LinkVar(SharedData().mut_prob, "mut_prob",
                       "Probability of each instruction mutating on reproduction.");
-      GetManager().LinkFuns<size_t>([this](){ return hardware.size(); },
-                       [this](const size_t & N){ hardware.Reset(); hardware.PushDefaultInst(N); },
+      GetManager().LinkFuns<size_t>([this](){ return genome.size(); },
+                       [this](const size_t & N){ genome.resize(0); genome.resize(N); GenomeChanged(); },
                        "N", "Initial number of instructions in genome");
       GetManager().LinkVar(SharedData().init_random, "init_random",
                       "Should we randomize ancestor?  (0 = \"blank\" default)");
@@ -111,21 +377,53 @@ namespace mabe {
                       "Name of variable to load inputs from.");
       GetManager().LinkVar(SharedData().output_name, "output_name",
                       "Name of variable to output results.");
+      GetManager().LinkVar(SharedData().fast_exec, "fast_exec",
+                      "Run genomes with a pre-decoded interpreter, compiled once per genome?");
+      GetManager().LinkVar(SharedData().persistent_state, "persistent_state",
+                      "Should each organism keep its own CPU state between executions?");
+      GetManager().LinkVar(SharedData().strip_introns, "strip_introns",
+                      "With fast_exec, skip instructions that cannot affect outputs? (Results are unchanged.)");
+      GetManager().LinkVar(SharedData().effective_name, "effective_name",
+                      "Name of variable for number of instructions that can affect outputs (\"\" for none).");
+      GetManager().LinkVar(SharedData().ins_prob, "ins_prob",
+                      "Probability of inserting a random instruction at each site on reproduction.");
+      GetManager().LinkVar(SharedData().del_prob, "del_prob",
+                      "Probability of deleting each instruction on reproduction.");
+      GetManager().LinkVar(SharedData().min_length, "min_length",
+                      "Smallest genome that deletions can produce.");
+      GetManager().LinkVar(SharedData().max_length, "max_length",
+                      "Largest genome that insertions can produce.");
     }
 
     /// Setup this organism type with the traits it need to track.
     void SetupModule() override {
       // Setup the mutation distribution.
-      SharedData().mut_dist.Setup(SharedData().mut_prob, hardware.GetSize());
+      SharedData().mut_dist.Setup(SharedData().mut_prob, genome.size());
 
       // Setup the default vector to indicate mutation positions.
-      SharedData().mut_sites.Resize(hardware.GetSize());
+      SharedData().mut_sites.Resize(genome.size());
+
+      // Setup skip sampling for mutations, insertions, and deletions.
+      if (SharedData().ins_prob < 0.0 || SharedData().ins_prob >= 1.0 ||
+          SharedData().del_prob < 0.0 || SharedData().del_prob >= 1.0) {
+        emp::notify::Error("AvidaGPOrg ins_prob and del_prob must be in [0.0, 1.0).");
+      }
+      SharedData().mut_skips.SetProb(SharedData().mut_prob);
+      SharedData().ins_skips.SetProb(SharedData().ins_prob);
+      SharedData().del_skips.SetProb(SharedData().del_prob);
+
+      // Translate the full instruction set now; organisms compile concurrently and only read it.
+      SharedData().op_map.Setup(*SharedData().inst_lib);
 
       // Setup the input and output traits.
       GetManager().AddRequiredTrait<emp::vector<double>>(SharedData().input_name);
       GetManager().AddSharedTrait(SharedData().output_name,
                                   "Value map output from organism.",
                                   emp::vector<double>());
+      if (SharedData().effective_name.size()) {
+        GetManager().AddOwnedTrait(SharedData().effective_name,
+                                   "Number of instructions that can affect outputs.", 0.0);
+      }
     }
   };
 
@@ -6,14 +6,19 @@
  *  @file  BitsOrg.hpp
  *  @brief An organism consisting of a series of bits.
  *  @note Status: ALPHA
+ *
+ *  The bits are held copy-on-write, so offspring share their parent's genome until mutated.
  */
 
 #ifndef MABE_BITS_ORGANISM_H
 #define MABE_BITS_ORGANISM_H
 
+#include "../core/GenomeView.hpp"
 #include "../core/MABE.hpp"
 #include "../core/Organism.hpp"
 #include "../core/OrganismManager.hpp"
+#include "../tools/CopyOnWrite.hpp"
+#include "../tools/Crossover.hpp"
 
 #include "emp/bits/BitVector.hpp"
 #include "emp/math/Distribution.hpp"
@@ -23,17 +28,69 @@ namespace mabe {
 
   class BitsOrg : public OrganismTemplate<BitsOrg> {
   protected:
-    emp::BitVector bits;
+    CopyOnWrite<emp::BitVector> bits;
+    MutationHistory history;   ///< Sites changed since this organism was copied.
+
+    /// If we are sharing the genome, point the output trait at this organism's own bits.
+    void LinkGenome() {
+      auto & data = SharedData();
+      if (!data.share_genome) return;
+      if (!data.output_linked) {
+        if (!HasTrait(data.output_name)) return;   // DataMap not setup yet (prototype)
+        data.output_id = GetDataMap().GetID(data.output_name);
+        data.output_linked = true;
+      }
+      SetTrait<GenomeView<emp::BitVector>>(data.output_id, GenomeView<emp::BitVector>(*bits));
+    }
+
+    /// Get modifiable bits, copying them first if they are shared with another organism.
+    emp::BitVector & EditBits() {
+      if (!bits.IsShared()) return bits.Edit();
+      emp::BitVector & out = bits.Edit();
+      LinkGenome();  // Bits have moved; update the output view.
+      return out;
+    }
+
+    /// Mutate the bits, recording each changed site in log (if provided).
+    size_t DoMutate(emp::Random & random, emp::Ptr<MutationLog> log) {
+      const size_t num_muts = SharedData().mut_dist.PickRandom(random);
+
+      if (num_muts == 0) return 0;
+      if (num_muts == 1) {
+        const size_t pos = random.GetUInt(bits->size());
+        if (log) log->AddSite(pos, (*bits)[pos]);
+        history.AddSite(pos, (*bits)[pos]);
+        EditBits().Toggle(pos);
+        return 1;
+      }
+
+      // Only remaining option is num_muts > 1.
+      auto & mut_sites = SharedData().mut_sites;
+      mut_sites.Clear();
+      for (size_t i = 0; i < num_muts; i++) {
+        const size_t pos = random.GetUInt(bits->size());
+        if (mut_sites[pos]) { --i; continue; }  // Duplicate position; try again.
+        mut_sites.Set(pos);
+        if (log) log->AddSite(pos, (*bits)[pos]);
+        history.AddSite(pos, (*bits)[pos]);
+      }
+      EditBits() ^= mut_sites;
+
+      return num_muts;
+    }
 
   public:
     BitsOrg(OrganismManager<BitsOrg> & _manager)
-      : OrganismTemplate<BitsOrg>(_manager), bits(100) { }
-    BitsOrg(const BitsOrg &) = default;
-    BitsOrg(BitsOrg &&) = default;
+      : OrganismTemplate<BitsOrg>(_manager), bits(emp::BitVector(100)) { }
+    BitsOrg(const BitsOrg & in)
+      : OrganismTemplate<BitsOrg>(in), bits(in.bits), history(in.history) { LinkGenome(); }
+    BitsOrg(BitsOrg && in)
+      : OrganismTemplate<BitsOrg>(std::move(in)), bits(std::move(in.bits)), history(in.history)
+    { LinkGenome(); }
     BitsOrg(const emp::BitVector & in, OrganismManager<BitsOrg> & _manager)
       : OrganismTemplate<BitsOrg>(_manager), bits(in) { }
     BitsOrg(size_t N, OrganismManager<BitsOrg> & _manager)
-      : OrganismTemplate<BitsOrg>(_manager), bits(N) { }
+      : OrganismTemplate<BitsOrg>(_manager), bits(emp::BitVector(N)) { }
     ~BitsOrg() { ; }
 
     struct ManagerData : public Organism::ManagerData {
@@ -42,51 +99,87 @@ namespace mabe {
       emp::Binomial mut_dist;            ///< Distribution of number of mutations to occur.
       emp::BitVector mut_sites;          ///< A pre-allocated vector for mutation sites. 
       bool init_random = true;           ///< Should we randomize ancestor?  (false = all zeros)
+      CrossoverType cross_type = CROSS_ONE_POINT;  ///< How should two genomes be recombined?
+      size_t cross_points = 2;           ///< Number of cut points for k-point crossover.
+      bool share_genome = true;          ///< Output a view of the bits rather than a copy?
+      bool output_linked = false;        ///< Has output_id been looked up yet?
+      size_t output_id = 0;              ///< DataMap ID of the output trait.
     };
 
     /// Use "to_string" to convert.
-    std::string ToString() const override { return emp::to_string(bits); }
+    std::string ToString() const override { return emp::to_string(*bits); }
 
-    size_t Mutate(emp::Random & random) override {
-      const size_t num_muts = SharedData().mut_dist.PickRandom(random);
+    size_t Mutate(emp::Random & random) override { return DoMutate(random, nullptr); }
 
-      if (num_muts == 0) return 0;
-      if (num_muts == 1) {
-        const size_t pos = random.GetUInt(bits.size());
-        bits.Toggle(pos);
-        return 1;
-      }
+    size_t MutateWithUndo(emp::Random & random, MutationLog & log) override {
+      log.Clear();
+      return DoMutate(random, &log);
+    }
 
-      // Only remaining option is num_muts > 1.
-      auto & mut_sites = SharedData().mut_sites;
-      mut_sites.Clear();
-      for (size_t i = 0; i < num_muts; i++) {
-        const size_t pos = random.GetUInt(bits.size());
-        if (mut_sites[pos]) { --i; continue; }  // Duplicate position; try again.
-        mut_sites.Set(pos);
+    bool RevertMutations(const MutationLog & log) override {
+      if (log.IsEmpty()) return true;
+      emp::BitVector & new_bits = EditBits();
+      for (size_t i = log.GetSize(); i > 0; --i) {
+        const size_t pos = log.GetSite(i-1);
+        history.AddSite(pos, new_bits[pos]);
+        new_bits.Set(pos, log.GetOldValue(i-1) != 0.0);
       }
-      bits ^= mut_sites;
+      return true;
+    }
 
-      return num_muts;
+    emp::Ptr<const MutationHistory> GetMutationHistory() const override { return &history; }
+
+    bool CanRecombine() const override { return true; }
+
+    /// Produce an offspring that takes each bit from this organism or parent2 based on a
+    /// crossover mask; the blend is done a whole word at a time.
+    [[nodiscard]] emp::Ptr<OrgType>
+    Recombine(emp::Ptr<OrgType> parent2, emp::Random & random) const override {
+      const auto & data = SharedData();
+      const emp::BitVector & bits1 = *bits;
+      const emp::BitVector & bits2 = *parent2.DynamicCast<BitsOrg>()->bits;
+      emp_assert(bits1.size() == bits2.size(), bits1.size(), bits2.size());
+
+      // Find the bits to take from parent2 that differ from ours, and flip those in a copy.
+      thread_local emp::BitVector mask;
+      thread_local emp::BitVector diff;
+      BuildCrossMask(random, bits1.size(), data.cross_type, data.cross_points, mask);
+      diff = bits1;
+      diff ^= bits2;
+      diff &= mask;
+
+      emp::Ptr<BitsOrg> offspring = Clone().DynamicCast<BitsOrg>();
+      if (diff.Any()) {
+        offspring->EditBits() ^= diff;
+        offspring->history.ForgetAll();
+      }
+      return offspring;
     }
 
     void Randomize(emp::Random & random) override {
-      emp::RandomizeBitVector(bits, random, 0.5);
+      emp::RandomizeBitVector(EditBits(), random, 0.5);
+      history.ForgetAll();
     }
 
     void Initialize(emp::Random & random) override {
-      if (SharedData().init_random) emp::RandomizeBitVector(bits, random, 0.5);
+      if (SharedData().init_random) Randomize(random);
     }
 
-    /// Put the bits in the correct output position.
+    /// Put the bits in the correct output position.  If the genome is being shared, the
+    /// output trait is already a live view of the bits and nothing needs to be done.
     void GenerateOutput() override {
-      SetTrait<emp::BitVector>(SharedData().output_name, bits);
+      if (SharedData().share_genome) return;
+      SetTrait<emp::BitVector>(SharedData().output_name, *bits);
+    }
+
+    std::string GetSharingStats() const override {
+      return emp::to_string("Genomes: ", CopyOnWrite<emp::BitVector>::GetStats().ToString("genomes"));
     }
 
     /// Setup this organism type to be able to load from config.
     void SetupConfig() override {
-      GetManager().LinkFuns<size_t>([this](){ return bits.size(); },
-                       [this](const size_t & N){ return bits.Resize(N); },
+      GetManager().LinkFuns<size_t>([this](){ return bits->size(); },
+                       [this](const size_t & N){ return EditBits().Resize(N); },
                        "N", "Number of bits in organism");
       GetManager().LinkVar(SharedData().mut_prob, "mut_prob",
                       "Probability of each bit mutating on reproduction.");
@@ -94,20 +187,36 @@ namespace mabe {
                       "Name of variable to contain bit sequence.");
       GetManager().LinkVar(SharedData().init_random, "init_random",
                       "Should we randomize ancestor?  (0 = all zeros)");
+      GetManager().LinkMenu(
+        SharedData().cross_type, "cross_type", "How should bits be recombined in sexual reproduction?",
+        CROSS_UNIFORM, "uniform", "Take each bit from either parent at random.",
+        CROSS_ONE_POINT, "one_point", "Swap parents at a single random point.",
+        CROSS_K_POINT, "k_point", "Alternate parents at cross_points random points." );
+      GetManager().LinkVar(SharedData().cross_points, "cross_points",
+                      "Number of crossover points to use with k_point crossover.");
+      GetManager().LinkVar(SharedData().share_genome, "share_genome",
+                      "Output a read-only view of the bits rather than a copy?  (0 = copy)");
     }
 
     /// Setup this organism type with the traits it need to track.
     void SetupModule() override {
       // Setup the mutation distribution.
-      SharedData().mut_dist.Setup(SharedData().mut_prob, bits.size());
+      SharedData().mut_dist.Setup(SharedData().mut_prob, bits->size());
 
       // Setup the default vector to indicate mutation positions.
-      SharedData().mut_sites.Resize(bits.size());
+      SharedData().mut_sites.Resize(bits->size());
 
       // Setup the output trait.
-      GetManager().AddSharedTrait(SharedData().output_name,
-                                  "Bitset output from organism.",
-                                  emp::BitVector(0));
+      if (SharedData().share_genome) {
+        GetManager().AddSharedTrait(SharedData().output_name,
+                                    "Bitset output from organism (view of genome).",
+                                    GenomeView<emp::BitVector>());
+      }
+      else {
+        GetManager().AddSharedTrait(SharedData().output_name,
+                                    "Bitset output from organism.",
+                                    emp::BitVector(0));
+      }
     }
   };
 
@@ -0,0 +1,168 @@
+/**
+ *  @note This file is part of MABE, https://github.com/mercere99/MABE2
+ *  @copyright Copyright (C) Michigan State University, MIT Software license; see doc/LICENSE.md
+ *  @date 2021.
+ *
+ *  @file  FixedBitsOrg.hpp
+ *  @brief An organism consisting of a fixed number of bits, set at compile time.
+ *  @note Status: ALPHA
+ *
+ *  FixedBitsOrg is a faster alternative to BitsOrg when the genome length is known in advance.
+ *  The bits are stored inline in an emp::BitSet, and mutations are placed using geometric skip
+ *  sampling (jumping directly from one mutated site to the next) so the cost of Mutate() scales
+ *  with the number of mutations rather than with the genome length.
+ *
+ *  Output is still provided as an emp::BitVector trait (so all bit-based evaluators work as-is);
+ *  it is filled 32 bits at a time.
+ *
+ *  Common sizes are registered as BitsOrg64, BitsOrg128, BitsOrg256, BitsOrg512, and BitsOrg1024.
+ */
+
+#ifndef MABE_FIXED_BITS_ORGANISM_H
+#define MABE_FIXED_BITS_ORGANISM_H
+
+#include "../core/MABE.hpp"
+#include "../core/Organism.hpp"
+#include "../core/OrganismManager.hpp"
+#include "../tools/SkipSampler.hpp"
+
+#include "emp/bits/BitSet.hpp"
+#include "emp/bits/BitVector.hpp"
+#include "emp/math/Random.hpp"
+
+namespace mabe {
+
+  template <size_t N>
+  class FixedBitsOrg : public OrganismTemplate<FixedBitsOrg<N>> {
+  private:
+    static_assert(N > 0 && N % 32 == 0, "FixedBitsOrg sizes must be a multiple of 32 bits.");
+    static constexpr size_t NUM_FIELDS = N / 32;   ///< Number of 32-bit fields in the genome.
+
+    using base_t = OrganismTemplate<FixedBitsOrg<N>>;
+
+  protected:
+    emp::BitSet<N> bits;
+    MutationHistory history;   ///< Sites changed since this organism was copied.
+
+    /// Mutate the bits, recording each changed site in log (if provided).
+    size_t DoMutate(emp::Random & random, emp::Ptr<MutationLog> log) {
+      const SkipSampler & skips = this->SharedData().mut_skips;
+      if (skips.GetProb() <= 0.0) return 0;
+
+      // Jump directly from one mutation site to the next.
+      size_t num_muts = 0;
+      for (size_t pos = skips.NextSkip(random, N); pos < N; pos += skips.NextSkip(random, N) + 1) {
+        if (log) log->AddSite(pos, bits[pos]);
+        history.AddSite(pos, bits[pos]);
+        bits.Toggle(pos);
+        ++num_muts;
+      }
+
+      return num_muts;
+    }
+
+  public:
+    FixedBitsOrg(OrganismManager<FixedBitsOrg<N>> & _manager) : base_t(_manager) { }
+    FixedBitsOrg(const FixedBitsOrg &) = default;
+    FixedBitsOrg(FixedBitsOrg &&) = default;
+    FixedBitsOrg(const emp::BitSet<N> & in, OrganismManager<FixedBitsOrg<N>> & _manager)
+      : base_t(_manager), bits(in) { }
+    ~FixedBitsOrg() { ; }
+
+    struct ManagerData : public Organism::ManagerData {
+      double mut_prob = 0.01;            ///< Probability of each bit mutating on reproduction.
+      std::string output_name = "bits";  ///< Name of trait that should be used to access bits.
+      bool init_random = true;           ///< Should we randomize ancestor?  (false = all zeros)
+
+      // Helper member variables.
+      SkipSampler mut_skips;             ///< Distance between mutations (from mut_prob).
+      bool output_linked = false;        ///< Has output_id been looked up yet?
+      size_t output_id = 0;              ///< DataMap ID of the output trait.
+    };
+
+    const emp::BitSet<N> & GetBits() const { return bits; }
+
+    /// Use "to_string" to convert.
+    std::string ToString() const override { return emp::to_string(bits); }
+
+    size_t Mutate(emp::Random & random) override { return DoMutate(random, nullptr); }
+
+    size_t MutateWithUndo(emp::Random & random, MutationLog & log) override {
+      log.Clear();
+      return DoMutate(random, &log);
+    }
+
+    bool RevertMutations(const MutationLog & log) override {
+      for (size_t i = log.GetSize(); i > 0; --i) {
+        const size_t pos = log.GetSite(i-1);
+        history.AddSite(pos, bits[pos]);
+        bits.Set(pos, log.GetOldValue(i-1) != 0.0);
+      }
+      return true;
+    }
+
+    emp::Ptr<const MutationHistory> GetMutationHistory() const override { return &history; }
+
+    void Randomize(emp::Random & random) override {
+      bits.Randomize(random);
+      history.ForgetAll();
+    }
+
+    void Initialize(emp::Random & random) override {
+      if (this->SharedData().init_random) Randomize(random);
+    }
+
+    /// Put the bits in the correct output position (copying a full field at a time).
+    void GenerateOutput() override {
+      auto & data = this->SharedData();
+      if (!data.output_linked) {
+        data.output_id = this->GetDataMap().GetID(data.output_name);
+        data.output_linked = true;
+      }
+      emp::BitVector & output = this->template GetTrait<emp::BitVector>(data.output_id);
+      if (output.size() != N) output.Resize(N);
+      for (size_t i = 0; i < NUM_FIELDS; ++i) output.SetUInt(i, bits.GetUInt(i));
+    }
+
+    /// Setup this organism type to be able to load from config.
+    void SetupConfig() override {
+      this->GetManager().LinkVar(this->SharedData().mut_prob, "mut_prob",
+                      "Probability of each bit mutating on reproduction.");
+      this->GetManager().LinkVar(this->SharedData().output_name, "output_name",
+                      "Name of variable to contain bit sequence.");
+      this->GetManager().LinkVar(this->SharedData().init_random, "init_random",
+                      "Should we randomize ancestor?  (0 = all zeros)");
+    }
+
+    /// Setup this organism type with the traits it need to track.
+    void SetupModule() override {
+      auto & data = this->SharedData();
+
+      // Pre-calculate the skip distribution for mutations.
+      if (data.mut_prob < 0.0 || data.mut_prob > 1.0) {
+        emp::notify::Error("FixedBitsOrg mut_prob must be between 0.0 and 1.0 (not ",
+                           data.mut_prob, ").");
+      }
+      data.mut_skips.SetProb(data.mut_prob);
+
+      // Setup the output trait.
+      this->GetManager().AddSharedTrait(data.output_name,
+                                        "Bitset output from organism.",
+                                        emp::BitVector(N));
+    }
+  };
+
+  using BitsOrg64 = FixedBitsOrg<64>;
+  using BitsOrg128 = FixedBitsOrg<128>;
+  using BitsOrg256 = FixedBitsOrg<256>;
+  using BitsOrg512 = FixedBitsOrg<512>;
+  using BitsOrg1024 = FixedBitsOrg<1024>;
+
+  MABE_REGISTER_ORG_TYPE(BitsOrg64, "Organism consisting of exactly 64 bits.");
+  MABE_REGISTER_ORG_TYPE(BitsOrg128, "Organism consisting of exactly 128 bits.");
+  MABE_REGISTER_ORG_TYPE(BitsOrg256, "Organism consisting of exactly 256 bits.");
+  MABE_REGISTER_ORG_TYPE(BitsOrg512, "Organism consisting of exactly 512 bits.");
+  MABE_REGISTER_ORG_TYPE(BitsOrg1024, "Organism consisting of exactly 1024 bits.");
+}
+
+#endif
@@ -0,0 +1,237 @@
+/**
+ *  @note This file is part of MABE, https://github.com/mercere99/MABE2
+ *  @copyright Copyright (C) Michigan State University, MIT Software license; see doc/LICENSE.md
+ *  @date 2021.
+ *
+ *  @file  NeuralNetOrg.hpp
+ *  @brief An organism consisting of a fixed-topology, fully-connected neural network.
+ *  @note Status: ALPHA
+ *
+ *  The topology is set with the "layers" setting (e.g., "4,8,8,2" for four inputs, two hidden
+ *  layers of eight nodes, and two outputs).  All weights and biases are stored in a single
+ *  contiguous vector (see tools/DenseNet.hpp for the layout); mutations add Gaussian noise to
+ *  individual parameters.  Inputs are read from the input trait and outputs are written to the
+ *  output trait; GenerateOutputBatch() runs many input cases in cache-sized blocks.
+ */
+
+#ifndef MABE_NEURAL_NET_ORGANISM_H
+#define MABE_NEURAL_NET_ORGANISM_H
+
+#include <algorithm>
+#include <cmath>
+
+#include "../core/MABE.hpp"
+#include "../core/Organism.hpp"
+#include "../core/OrganismManager.hpp"
+#include "../tools/DenseNet.hpp"
+#include "../tools/SkipSampler.hpp"
+#include "../tools/StreamHash.hpp"
+#include "../tools/Ziggurat.hpp"
+
+#include "emp/base/vector.hpp"
+#include "emp/math/Random.hpp"
+#include "emp/tools/string_utils.hpp"
+
+namespace mabe {
+
+  class NeuralNetOrg : public OrganismTemplate<NeuralNetOrg> {
+  protected:
+    emp::vector<double> params;   ///< All weights and biases, one layer after another.
+    MutationHistory history;      ///< Sites changed since this organism was copied.
+
+    /// Mutate the parameters, recording each changed site in log (if provided).
+    size_t DoMutate(emp::Random & random, emp::Ptr<MutationLog> log) {
+      auto & data = SharedData();
+      if (data.mut_prob <= 0.0) return 0;
+
+      // Identify positions for mutations, jumping directly from one site to the next.
+      const size_t N = params.size();
+      emp::vector<size_t> & mut_sites = data.mut_sites;
+      mut_sites.resize(0);
+      const SkipSampler & skips = data.mut_skips;
+      for (size_t pos = skips.NextSkip(random, N); pos < N; pos += skips.NextSkip(random, N) + 1) {
+        mut_sites.push_back(pos);
+      }
+      const size_t num_muts = mut_sites.size();
+      if (num_muts == 0) return 0;
+
+      // Draw all of the mutation sizes at once, then apply them.
+      emp::vector<double> & mut_vals = data.mut_vals;
+      mut_vals.resize(num_muts);
+      FillNormal(random, mut_vals.data(), num_muts, 0.0, data.mut_size);
+      for (size_t i = 0; i < num_muts; ++i) {
+        double & param = params[mut_sites[i]];
+        if (log) log->AddSite(mut_sites[i], param);
+        history.AddSite(mut_sites[i], param);
+        param += mut_vals[i];
+        data.ApplyLimit(param);
+      }
+
+      return num_muts;
+    }
+
+  public:
+    struct ManagerData : public Organism::ManagerData {
+      std::string layers = "2,8,1";          ///< Comma-separated layer sizes (inputs first).
+      DenseNet::Activation hidden_act = DenseNet::ACT_TANH;    ///< Activation for hidden layers.
+      DenseNet::Activation output_act = DenseNet::ACT_LINEAR;  ///< Activation for output layer.
+      double mut_prob = 0.01;                ///< Probability of each parameter mutating.
+      double mut_size = 0.1;                 ///< Standard deviation of mutations.
+      double max_weight = 10.0;              ///< Parameters are clamped to +/- this (0 = no limit)
+      bool init_random = true;               ///< Should we randomize ancestor?  (false = all 0.0)
+      std::string input_name = "input";      ///< Name of trait to load inputs from.
+      std::string output_name = "output";    ///< Name of trait to store outputs in.
+
+      // Helper member variables.
+      DenseNet net;                          ///< Topology built from layers.
+      SkipSampler mut_skips;                 ///< Distance between mutations (from mut_prob).
+      emp::vector<size_t> mut_sites;         ///< A pre-allocated vector for mutation sites.
+      emp::vector<double> mut_vals;          ///< A pre-allocated vector for mutation sizes.
+
+      void ApplyLimit(double & value) const {
+        if (max_weight > 0.0) value = std::clamp(value, -max_weight, max_weight);
+      }
+    };
+
+    NeuralNetOrg(OrganismManager<NeuralNetOrg> & _manager)
+      : OrganismTemplate<NeuralNetOrg>(_manager) { }
+    NeuralNetOrg(const NeuralNetOrg &) = default;
+    NeuralNetOrg(NeuralNetOrg &&) = default;
+    ~NeuralNetOrg() { ; }
+
+    const emp::vector<double> & GetParams() const { return params; }
+
+    std::string ToString() const override { return emp::to_string(params); }
+
+    size_t GetGenomeHash() const override {
+      StreamHash hash(params.size());
+      for (double param : params) hash.AddDouble(param);
+      return hash.Get();
+    }
+
+    size_t Mutate(emp::Random & random) override { return DoMutate(random, nullptr); }
+
+    size_t MutateWithUndo(emp::Random & random, MutationLog & log) override {
+      log.Clear();
+      return DoMutate(random, &log);
+    }
+
+    bool RevertMutations(const MutationLog & log) override {
+      for (size_t i = log.GetSize(); i > 0; --i) {
+        double & param = params[log.GetSite(i-1)];
+        history.AddSite(log.GetSite(i-1), param);
+        param = log.GetOldValue(i-1);
+      }
+      return true;
+    }
+
+    emp::Ptr<const MutationHistory> GetMutationHistory() const override { return &history; }
+
+    /// Weights are drawn from a normal distribution scaled by 1/sqrt(fan-in); biases start at 0.
+    void Randomize(emp::Random & random) override {
+      const DenseNet & net = SharedData().net;
+      params.resize(net.GetNumParams());
+      for (size_t layer = 0; layer < net.GetNumLayers(); ++layer) {
+        double * layer_params = params.data() + net.GetLayerOffset(layer);
+        const size_t num_weights = net.GetNumWeights(layer);
+        const double scale = 1.0 / std::sqrt((double) net.GetLayerInputs(layer));
+        FillNormal(random, layer_params, num_weights, 0.0, scale);
+        for (size_t i = 0; i < num_weights; ++i) SharedData().ApplyLimit(layer_params[i]);
+        std::fill(layer_params + num_weights,
+                  layer_params + num_weights + net.GetLayerOutputs(layer), 0.0);
+      }
+      history.ForgetAll();
+    }
+
+    void Initialize(emp::Random & random) override {
+      if (SharedData().init_random) Randomize(random);
+      else {
+        params.assign(SharedData().net.GetNumParams(), 0.0);
+        history.ForgetAll();
+      }
+    }
+
+    /// Run the network on the input trait and store the results in the output trait.
+    void GenerateOutput() override {
+      const auto & data = SharedData();
+      const emp::vector<double> & inputs = GetTrait<emp::vector<double>>(data.input_name);
+      emp::vector<double> & outputs = GetTrait<emp::vector<double>>(data.output_name);
+      outputs.resize(data.net.GetNumOutputs());
+      data.net.Forward(params.data(), inputs, outputs.data(), outputs.size());
+    }
+
+    /// Run the network on each input case, writing outputs into a case-by-output matrix.
+    bool GenerateOutputBatch(const emp::vector<emp::vector<double>> & inputs,
+                             emp::vector<double> & outputs,
+                             size_t num_outputs) override {
+      outputs.resize(inputs.size() * num_outputs);
+      SharedData().net.ForwardBatch(params.data(), inputs, outputs.data(), num_outputs);
+      return true;
+    }
+
+    /// Setup this organism type to be able to load from config.
+    void SetupConfig() override {
+      GetManager().LinkVar(SharedData().layers, "layers",
+                      "Comma-separated layer sizes, from inputs to outputs (e.g., \"4,8,2\").");
+      GetManager().LinkMenu(
+        SharedData().hidden_act, "hidden_act", "Activation function for hidden layers.",
+        DenseNet::ACT_LINEAR, "linear", "Pass values through unchanged.",
+        DenseNet::ACT_RELU, "relu", "Set negative values to zero.",
+        DenseNet::ACT_TANH, "tanh", "Squash values into (-1, 1).",
+        DenseNet::ACT_SIGMOID, "sigmoid", "Squash values into (0, 1)." );
+      GetManager().LinkMenu(
+        SharedData().output_act, "output_act", "Activation function for the output layer.",
+        DenseNet::ACT_LINEAR, "linear", "Pass values through unchanged.",
+        DenseNet::ACT_RELU, "relu", "Set negative values to zero.",
+        DenseNet::ACT_TANH, "tanh", "Squash values into (-1, 1).",
+        DenseNet::ACT_SIGMOID, "sigmoid", "Squash values into (0, 1)." );
+      GetManager().LinkVar(SharedData().mut_prob, "mut_prob",
+                      "Probability of each weight or bias mutating on reproduction.");
+      GetManager().LinkVar(SharedData().mut_size, "mut_size",
+                      "Standard deviation on size of mutations.");
+      GetManager().LinkVar(SharedData().max_weight, "max_weight",
+                      "Largest magnitude allowed for a weight or bias (0 = no limit).");
+      GetManager().LinkVar(SharedData().init_random, "init_random",
+                      "Should we randomize ancestor?  (0 = all 0.0)");
+      GetManager().LinkVar(SharedData().input_name, "input_name",
+                      "Name of variable to load inputs from.");
+      GetManager().LinkVar(SharedData().output_name, "output_name",
+                      "Name of variable to output results.");
+    }
+
+    /// Setup this organism type with the traits it need to track.
+    void SetupModule() override {
+      auto & data = SharedData();
+
+      // Build the network topology.
+      emp::vector<size_t> sizes;
+      for (const std::string & size_str : emp::slice(data.layers, ',')) {
+        sizes.push_back(emp::from_string<size_t>(size_str));
+      }
+      if (!data.net.Setup(sizes, data.hidden_act, data.output_act)) {
+        emp::notify::Error("NeuralNetOrg layers must list at least two non-zero sizes (not \"",
+                           data.layers, "\").");
+      }
+      params.resize(data.net.GetNumParams(), 0.0);
+
+      // Pre-calculate the skip distribution for mutations.
+      if (data.mut_prob < 0.0 || data.mut_prob > 1.0) {
+        emp::notify::Error("NeuralNetOrg mut_prob must be between 0.0 and 1.0 (not ",
+                           data.mut_prob, ").");
+      }
+      data.mut_skips.SetProb(data.mut_prob);
+      data.mut_sites.reserve(params.size());
+      data.mut_vals.reserve(params.size());
+
+      // Setup the input and output traits.
+      GetManager().AddRequiredTrait<emp::vector<double>>(data.input_name);
+      GetManager().AddSharedTrait(data.output_name,
+                                  "Value vector output from organism.",
+                                  emp::vector<double>(data.net.GetNumOutputs()));
+    }
+  };
+
+  MABE_REGISTER_ORG_TYPE(NeuralNetOrg, "Organism consisting of a fully-connected neural network.");
+}
+
+#endif
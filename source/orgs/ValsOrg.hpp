@@ -6,25 +6,35 @@
  *  @file ValsOrg.hpp
  *  @brief An organism consisting of a series of values of type double.
  *  @note Status: ALPHA
+ *
+ *  The values are held copy-on-write, so offspring share their parent's genome until mutated.
  */
 
 #ifndef MABE_VALS_ORGANISM_H
 #define MABE_VALS_ORGANISM_H
 
+#include <algorithm>
+#include <cmath>
+
+#include "../core/GenomeView.hpp"
 #include "../core/MABE.hpp"
 #include "../core/Organism.hpp"
 #include "../core/OrganismManager.hpp"
+#include "../tools/CopyOnWrite.hpp"
+#include "../tools/Crossover.hpp"
+#include "../tools/SkipSampler.hpp"
+#include "../tools/Ziggurat.hpp"
 
 #include "emp/base/vector.hpp"
-#include "emp/math/Distribution.hpp"
 #include "emp/math/random_utils.hpp"
 
 namespace mabe {
 
   class ValsOrg : public OrganismTemplate<ValsOrg> {
   protected:
-    emp::vector<double> vals;  // Set of values that make up organism.
-    double total = 0.0;        // Dynamic total of values in organism.
+    CopyOnWrite<emp::vector<double>> vals;  // Set of values that make up organism.
+    double total = 0.0;                     // Dynamic total of values in organism.
+    MutationHistory history;                // Sites changed since this organism was copied.
 
     // How do we enforce limits on values?
     enum BoundType {
@@ -36,10 +46,62 @@ namespace mabe {
     };
 
     void CalculateTotal() {
-      for (double x : vals) total += x;
+      total = 0.0;
+      for (double x : *vals) total += x;
       SetTrait<double>(SharedData().total_name, total);
     }
 
+    /// If we are sharing the genome, point the output trait at this organism's own values.
+    inline void LinkGenome();
+
+    /// Get modifiable values, copying them first if they are shared with another organism.
+    emp::vector<double> & EditVals() {
+      if (!vals.IsShared()) return vals.Edit();
+      emp::vector<double> & out = vals.Edit();
+      LinkGenome();  // Values have moved; update the output view.
+      return out;
+    }
+
+    /// Mutate the values, recording each changed site in log (if provided).
+    size_t DoMutate(emp::Random & random, emp::Ptr<MutationLog> log) {
+      auto & data = SharedData();
+      if (data.mut_prob <= 0.0) return 0;
+
+      // Identify positions for mutations, jumping directly from one site to the next.
+      const size_t N = vals->size();
+      emp::vector<size_t> & mut_sites = data.mut_sites;
+      mut_sites.resize(0);
+      const SkipSampler & skips = data.mut_skips;
+      for (size_t pos = skips.NextSkip(random, N); pos < N; pos += skips.NextSkip(random, N) + 1) {
+        mut_sites.push_back(pos);
+      }
+      const size_t num_muts = mut_sites.size();
+      if (num_muts == 0) return 0;
+
+      // Draw all of the mutation sizes at once, then shift them to be new values.
+      emp::vector<double> & mut_vals = data.mut_vals;
+      mut_vals.resize(num_muts);
+      FillNormal(random, mut_vals.data(), num_muts, 0.0, data.mut_size);
+      const emp::vector<double> & old_vals = *vals;
+      for (size_t i = 0; i < num_muts; ++i) mut_vals[i] += old_vals[mut_sites[i]];
+
+      // Make sure all new values stay in the allowed range.
+      data.ApplyBounds(mut_vals.data(), num_muts);
+
+      // Put the new values in place (in a private copy), updating the total as we go.
+      emp::vector<double> & new_vals = EditVals();
+      for (size_t i = 0; i < num_muts; ++i) {
+        double & cur_val = new_vals[mut_sites[i]];
+        if (log) log->AddSite(mut_sites[i], cur_val);
+        history.AddSite(mut_sites[i], cur_val);
+        total += mut_vals[i] - cur_val;
+        cur_val = mut_vals[i];
+      }
+
+      SetTrait<double>(data.total_name, total);  // Store total in data map.
+      return num_muts;
+    }
+
   public:
     struct ManagerData : public Organism::ManagerData {
       std::string output_name = "vals";  ///< Name of trait that should be used to access values.
@@ -50,80 +112,122 @@ namespace mabe {
       double max_value = 100.0;          ///< Largest that values are allowed to be.
       BoundType upper_bound = LIMIT_REBOUND;
       BoundType lower_bound = LIMIT_REBOUND;
+      CrossoverType cross_type = CROSS_ONE_POINT;  ///< How should two genomes be recombined?
+      size_t cross_points = 2;           ///< Number of cut points for k-point crossover.
 
       // Helper member variables.
-      emp::Binomial mut_dist;            ///< Distribution of number of mutations to occur.
-      emp::BitVector mut_sites;          ///< A pre-allocated vector for mutation sites. 
+      SkipSampler mut_skips;             ///< Distance between mutations (from mut_prob).
+      emp::vector<size_t> mut_sites;     ///< A pre-allocated vector for mutation sites.
+      emp::vector<double> mut_vals;      ///< A pre-allocated vector for new values at sites.
       bool init_random = true;           ///< Should we randomize ancestor?  (false = all 0.0)
+      bool share_genome = true;          ///< Output a view of the values rather than a copy?
+      bool output_linked = false;        ///< Has output_id been looked up yet?
+      size_t output_id = 0;              ///< DataMap ID of the output trait.
 
       // Helper functions.
-      inline void ApplyBounds(double & value);              ///< Put a single value back in range.
-      inline void ApplyBounds(emp::vector<double> & vals);  ///< Put all values back in range.
+      inline void ApplyBounds(double * vals, size_t count); ///< Put an array of values in range.
+      void ApplyBounds(double & value) { ApplyBounds(&value, 1); }
+      void ApplyBounds(emp::vector<double> & vals) { ApplyBounds(vals.data(), vals.size()); }
     };
 
     ValsOrg(OrganismManager<ValsOrg> & _manager)
-      : OrganismTemplate<ValsOrg>(_manager), vals(100, 0.0), total(0.0) { }
-    ValsOrg(const ValsOrg &) = default;
-    ValsOrg(ValsOrg &&) = default;
+      : OrganismTemplate<ValsOrg>(_manager), vals(emp::vector<double>(100, 0.0)), total(0.0) { }
+    ValsOrg(const ValsOrg & in)
+      : OrganismTemplate<ValsOrg>(in), vals(in.vals), total(in.total), history(in.history)
+    { LinkGenome(); }
+    ValsOrg(ValsOrg && in)
+      : OrganismTemplate<ValsOrg>(std::move(in)), vals(std::move(in.vals)), total(in.total)
+      , history(in.history)
+    { LinkGenome(); }
     ValsOrg(const emp::vector<double> & in, OrganismManager<ValsOrg> & _manager)
       : OrganismTemplate<ValsOrg>(_manager), vals(in)
     {
-      SharedData().ApplyBounds(vals);  // Make sure all data is within range.
+      SharedData().ApplyBounds(vals.Edit());  // Make sure all data is within range.
       CalculateTotal();
     }
     ValsOrg(size_t N, OrganismManager<ValsOrg> & _manager)
-      : OrganismTemplate<ValsOrg>(_manager), vals(N, 0.0), total(0.0) { }
+      : OrganismTemplate<ValsOrg>(_manager), vals(emp::vector<double>(N, 0.0)), total(0.0) { }
     ~ValsOrg() { ; }
 
     /// Use "to_string" to convert.
-    std::string ToString() const override { return emp::to_string(vals, ":(TOTAL=", total, ")"); }
-
-    size_t Mutate(emp::Random & random) override {
-      // Identify number of and positions for mutations.
-      const size_t num_muts = SharedData().mut_dist.PickRandom(random);
-      emp::BitVector & mut_sites = SharedData().mut_sites;
-      mut_sites.ChooseRandom(random, num_muts);
-
-      // Trigger mutations at the identified positions.
-      int mut_pos = mut_sites.FindOne();
-      while (mut_pos != -1) {
-        double & cur_val = vals[mut_pos];        // Identify the next site to mutate.
-        total -= cur_val;                        // Remove old value from the total.
-        cur_val += random.GetRandNormal();       // Mutate the value at the site.
-        SharedData().ApplyBounds(cur_val);       // Make sure the value stays in the allowed range.
-        total += cur_val;                        // Add the update value back into the total.
-        mut_pos = mut_sites.FindOne(mut_pos+1);  // Move on to the next site to mutate.
+    std::string ToString() const override { return emp::to_string(*vals, ":(TOTAL=", total, ")"); }
+
+    size_t Mutate(emp::Random & random) override { return DoMutate(random, nullptr); }
+
+    size_t MutateWithUndo(emp::Random & random, MutationLog & log) override {
+      log.Clear();
+      return DoMutate(random, &log);
+    }
+
+    bool RevertMutations(const MutationLog & log) override {
+      if (log.IsEmpty()) return true;
+      emp::vector<double> & new_vals = EditVals();
+      for (size_t i = log.GetSize(); i > 0; --i) {
+        double & cur_val = new_vals[log.GetSite(i-1)];
+        history.AddSite(log.GetSite(i-1), cur_val);
+        total += log.GetOldValue(i-1) - cur_val;
+        cur_val = log.GetOldValue(i-1);
       }
+      SetTrait<double>(SharedData().total_name, total);
+      return true;
+    }
 
-      SetTrait<double>(SharedData().total_name, total);  // Store total in data map.
-      return num_muts;
+    emp::Ptr<const MutationHistory> GetMutationHistory() const override { return &history; }
+
+    bool CanRecombine() const override { return true; }
+
+    /// Produce an offspring that copies slices of values from parent2 between crossover points.
+    [[nodiscard]] emp::Ptr<OrgType>
+    Recombine(emp::Ptr<OrgType> parent2, emp::Random & random) const override {
+      const auto & data = SharedData();
+      const emp::vector<double> & vals2 = *parent2.DynamicCast<ValsOrg>()->vals;
+      emp_assert(vals->size() == vals2.size(), vals->size(), vals2.size());
+
+      emp::Ptr<ValsOrg> offspring = Clone().DynamicCast<ValsOrg>();
+      CrossVectors(random, vals2, data.cross_type, data.cross_points, offspring->EditVals());
+      offspring->CalculateTotal();
+      offspring->history.ForgetAll();
+      return offspring;
     }
 
     void Randomize(emp::Random & random) override {
       total = 0.0;
-      for (double & x : vals) {
+      for (double & x : EditVals()) {
         x = random.GetDouble(SharedData().min_value, SharedData().max_value);
         total += x;
       }
       SetTrait<double>(SharedData().total_name, total);  // Store total in data map.
+      history.ForgetAll();
     }
 
     void Initialize(emp::Random & random) override {
       if (SharedData().init_random) Randomize(random);
-      else { total = 0.0; for (double & x : vals) x = 0.0; }
+      else {
+        total = 0.0;
+        for (double & x : EditVals()) x = 0.0;
+        history.ForgetAll();
+      }
     }
 
 
-    /// Put the values in the correct output positions.
+    /// Put the values in the correct output positions.  If the genome is being shared, the
+    /// output trait is already a live view of the values and only the total needs updating.
     void GenerateOutput() override {
-      SetTrait<emp::vector<double>>(SharedData().output_name, vals);
+      if (!SharedData().share_genome) {
+        SetTrait<emp::vector<double>>(SharedData().output_name, *vals);
+      }
       SetTrait<double>(SharedData().total_name, total);
     }
 
+    std::string GetSharingStats() const override {
+      return emp::to_string("Genomes: ",
+                            CopyOnWrite<emp::vector<double>>::GetStats().ToString("genomes"));
+    }
+
     /// Setup this organism type to be able to load from config.
     void SetupConfig() override {
-      GetManager().LinkFuns<size_t>([this](){ return vals.size(); },
-                       [this](const size_t & N){ return vals.resize(N, 0.0); },
+      GetManager().LinkFuns<size_t>([this](){ return vals->size(); },
+                       [this](const size_t & N){ return EditVals().resize(N, 0.0); },
                        "N", "Number of values in organism");
       GetManager().LinkVar(SharedData().mut_prob, "mut_prob",
                       "Probability of each value mutating on reproduction.");
@@ -145,26 +249,47 @@ namespace mabe {
         LIMIT_CLAMP, "clamp", "Reduce too-high values to max_value.",
         LIMIT_WRAP, "wrap", "Make high values loop around to minimum.",
         LIMIT_REBOUND, "rebound", "Make high values 'bounce' back down." );
+      GetManager().LinkMenu(
+        SharedData().cross_type, "cross_type", "How should values be recombined in sexual reproduction?",
+        CROSS_UNIFORM, "uniform", "Take each value from either parent at random.",
+        CROSS_ONE_POINT, "one_point", "Swap parents at a single random point.",
+        CROSS_K_POINT, "k_point", "Alternate parents at cross_points random points." );
+      GetManager().LinkVar(SharedData().cross_points, "cross_points",
+                      "Number of crossover points to use with k_point crossover.");
       GetManager().LinkVar(SharedData().output_name, "output_name",
                       "Name of variable to contain set of values.");
       GetManager().LinkVar(SharedData().total_name, "total_name",
                       "Name of variable to contain total of all values.");
       GetManager().LinkVar(SharedData().init_random, "init_random",
                       "Should we randomize ancestor?  (0 = all 0.0)");
+      GetManager().LinkVar(SharedData().share_genome, "share_genome",
+                      "Output a read-only view of the values rather than a copy?  (0 = copy)");
     }
 
     /// Setup this organism type with the traits it need to track.
     void SetupModule() override {
       // Setup the mutation distribution.
-      SharedData().mut_dist.Setup(SharedData().mut_prob, vals.size());
+      if (SharedData().mut_prob < 0.0 || SharedData().mut_prob > 1.0) {
+        emp::notify::Error("ValsOrg mut_prob must be between 0.0 and 1.0 (not ",
+                           SharedData().mut_prob, ").");
+      }
+      SharedData().mut_skips.SetProb(SharedData().mut_prob);
 
-      // Setup the default vector to indicate mutation positions.
-      SharedData().mut_sites.Resize(vals.size());
+      // Pre-allocate space to track mutation positions and values.
+      SharedData().mut_sites.reserve(vals->size());
+      SharedData().mut_vals.reserve(vals->size());
 
       // Setup the output trait.
-      GetManager().AddSharedTrait(SharedData().output_name,
-                                  "Value vector output from organism.",
-                                  emp::vector<double>(vals.size()));
+      if (SharedData().share_genome) {
+        GetManager().AddSharedTrait(SharedData().output_name,
+                                    "Value vector output from organism (view of genome).",
+                                    GenomeView<emp::vector<double>>());
+      }
+      else {
+        GetManager().AddSharedTrait(SharedData().output_name,
+                                    "Value vector output from organism.",
+                                    emp::vector<double>(vals->size()));
+      }
       // Setup the output trait.
       GetManager().AddSharedTrait(SharedData().total_name,
                                   "Total of all organism outputs.",
@@ -175,52 +300,48 @@ namespace mabe {
   ///////////////////////////////////////////////////////////////////////////////////////////
   //  Helper functions....
 
-  void ValsOrg::ManagerData::ApplyBounds(double & value) {
-    if (value > max_value) {
-      switch (upper_bound) {
-        case LIMIT_NONE:    break;
-        case LIMIT_CLAMP:   value = max_value; break;
-        case LIMIT_WRAP:    value -= (max_value - min_value); break;
-        case LIMIT_REBOUND: value = 2 * max_value - value; break;
-        case LIMIT_ERROR:   break;  // For now; perhaps do somethign with error?
-      }
-    }
-    else if (value < min_value) {
-      switch (lower_bound) {
-        case LIMIT_NONE:    break;
-        case LIMIT_CLAMP:   value = min_value; break;
-        case LIMIT_WRAP:    value += (max_value - min_value); break;
-        case LIMIT_REBOUND: value = 2 * min_value - value; break;
-        case LIMIT_ERROR:   break;  // For now; perhaps do somethign with error?
-      }
+  void ValsOrg::LinkGenome() {
+    auto & data = SharedData();
+    if (!data.share_genome) return;
+    if (!data.output_linked) {
+      if (!HasTrait(data.output_name)) return;   // DataMap not setup yet (prototype)
+      data.output_id = GetDataMap().GetID(data.output_name);
+      data.output_linked = true;
     }
+    SetTrait<GenomeView<emp::vector<double>>>(data.output_id, GenomeView<emp::vector<double>>(*vals));
   }
 
-  void ValsOrg::ManagerData::ApplyBounds(emp::vector<double> & vals) {
-    const size_t range_size = max_value - min_value;
+  // Each boundary type is applied in its own loop, using arithmetic rather than branches
+  // so that the compiler can vectorize the loops.
+  void ValsOrg::ManagerData::ApplyBounds(double * vals, size_t count) {
+    const double range_size = max_value - min_value;
 
     switch (upper_bound) {
-    case LIMIT_NONE: break;
     case LIMIT_CLAMP:
-      for (double & value : vals) {
-        if (value > max_value) value = max_value;
-        else if (value < min_value) value = min_value;        
-      }
+      for (size_t i = 0; i < count; ++i) vals[i] = std::min(vals[i], max_value);
       break;
     case LIMIT_WRAP:
-      for (double & value : vals) {
-        if (value > max_value) value -= range_size;
-        else if (value < min_value) value += range_size;        
-      }
+      for (size_t i = 0; i < count; ++i) vals[i] -= range_size * (double) (vals[i] > max_value);
       break;
     case LIMIT_REBOUND:
-      for (double & value : vals) {
-        if (value > max_value) value = 2 * max_value - value;
-        else if (value < min_value) value = 2 * min_value - value;
-      }
+      for (size_t i = 0; i < count; ++i) vals[i] = max_value - std::abs(max_value - vals[i]);
+      break;
+    default:
+      break;  // No limit (or invalid limit; for now, perhaps do something with error?)
+    }
+
+    switch (lower_bound) {
+    case LIMIT_CLAMP:
+      for (size_t i = 0; i < count; ++i) vals[i] = std::max(vals[i], min_value);
+      break;
+    case LIMIT_WRAP:
+      for (size_t i = 0; i < count; ++i) vals[i] += range_size * (double) (vals[i] < min_value);
+      break;
+    case LIMIT_REBOUND:
+      for (size_t i = 0; i < count; ++i) vals[i] = min_value + std::abs(vals[i] - min_value);
       break;
     default:
-      break; // Should probably throw error.
+      break;  // No limit (or invalid limit; for now, perhaps do something with error?)
     }
   }
 
@@ -154,7 +154,8 @@ namespace mabe {
       // All of the traits used are required to be generated by another module.
       emp::vector<std::string> trait_names = emp::slice(trait_inputs);
       for (const std::string & name : trait_names) {
-        AddRequiredTrait<double, emp::vector<double>>(name);
+        AddRequiredTrait<double, emp::vector<double>, GenomeView<emp::vector<double>>,
+                         InlineTraitVector<double>>(name);
       }
     }
 
@@ -20,6 +20,8 @@ namespace mabe {
   private:
     std::string fit_equation;     ///< Trait function that we should select on
     size_t tourny_size;      ///< Number of organisms in each tournament
+    bool recombine = false;  ///< Should offspring have two parents (each a tournament winner)?
+    bool recombine_warned = false;  ///< Have we warned that orgs cannot recombine?
 
     Collection Select(Population & select_pop, Population & birth_pop, size_t num_births) {
       emp::Random & random = control.GetRandom();
@@ -36,23 +38,44 @@ namespace mabe {
       // Track where all organisms are placed.
       Collection placement_list;
 
-      // Loop through each round of tournament selection.
-      for (size_t round = 0; round < num_births; round++) {
+      // Run a single tournament and return the position of the winner; the organism at
+      // skip_id (if any) is never entered.
+      auto run_tournament = [&](size_t skip_id=(size_t)-1) {
         // Find a random organism in the population and call it "best"
+        // @CAO: better way for sparse pop?
         size_t best_id = random.GetUInt(N);
-        while (select_pop[best_id].IsEmpty()) best_id = random.GetUInt(N); // @CAO: better way for sparse pop?
+        while (select_pop[best_id].IsEmpty() || best_id == skip_id) best_id = random.GetUInt(N);
         double best_fit = fit_fun(select_pop[best_id]);
 
         // Loop through other organisms for the rest of the tournament size, and pick best.
         for (size_t test=1; test < tourny_size; test++) {
           size_t test_id = random.GetUInt(N);
-          while (select_pop[test_id].IsEmpty()) test_id = random.GetUInt(N);
+          while (select_pop[test_id].IsEmpty() || test_id == skip_id) test_id = random.GetUInt(N);
           double test_fit = fit_fun(select_pop[test_id]);          
           if (test_fit > best_fit) {
             best_id = test_id;
             best_fit = test_fit;
           }
         }
+        return best_id;
+      };
+
+      // Loop through each round of tournament selection.
+      for (size_t round = 0; round < num_births; round++) {
+        const size_t best_id = run_tournament();
+
+        // If recombining, a second tournament (without the first winner) picks the mate.
+        if (recombine && select_pop[best_id].CanRecombine() && select_pop.GetNumOrgs() > 1) {
+          const size_t mate_id = run_tournament(best_id);
+          placement_list += control.DoBirth(select_pop[best_id], select_pop.IteratorAt(best_id),
+                                            select_pop[mate_id], birth_pop, 1);
+          continue;
+        }
+        if (recombine && !recombine_warned && !select_pop[best_id].CanRecombine()) {
+          emp::notify::Warning("SelectTournament module '", GetName(), "' has recombine set, but ",
+                               "organism type cannot recombine; replicating asexually instead.");
+          recombine_warned = true;
+        }
 
         // Replicate the organism that did best in this tournament.
         placement_list += control.Replicate(select_pop.IteratorAt(best_id), birth_pop, 1);
@@ -87,6 +110,8 @@ namespace mabe {
     void SetupConfig() override {
       LinkVar(tourny_size, "tournament_size", "Number of orgs in each tournament");
       LinkVar(fit_equation, "fitness_fun", "Trait equation that produces fitness value to use");
+      LinkVar(recombine, "recombine",
+              "Recombine each winner with the winner of a second tournament? (Org type must support it)");
     }
 
     void SetupModule() override {
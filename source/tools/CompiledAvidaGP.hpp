@@ -0,0 +1,527 @@
+/**
+ *  @note This file is part of MABE, https://github.com/mercere99/MABE2
+ *  @copyright Copyright (C) Michigan State University, MIT Software license; see doc/LICENSE.md
+ *  @date 2021.
+ *
+ *  @file  CompiledAvidaGP.hpp
+ *  @brief A pre-decoded, switch-dispatched interpreter for AvidaGP genomes.
+ *  @note Status: ALPHA
+ *
+ *  emp::AvidaGP executes each instruction by looking it up in its instruction library and
+ *  calling through a function table.  CompiledAvidaGP translates a genome ONCE into a compact
+ *  array of 4-byte instructions (opcode + three register arguments) and then runs it with a
+ *  single switch, with no per-step lookups.  Scope boundaries are also pre-computed so that
+ *  skipping over a scope only needs to examine scope-changing instructions.
+ *
+ *  The interpreter follows the semantics of the standard AvidaGP instruction set (Inc, Dec, Not,
+ *  SetReg, Add, Sub, Mult, Div, Mod, TestEqu, TestNEqu, TestLess, If, While, Countdown, Break,
+ *  Scope, Define, Call, Push, Pop, Input, Output, CopyVal, ScopeReg), including one CPU cycle
+ *  per instruction executed.  Genomes that use any other instruction cannot be compiled;
+ *  Compile() returns false and the caller should fall back on emp::AvidaGP.
+ *
+ *  As in emp::AvidaGP, input and output IDs are register values truncated with an (int) cast,
+ *  so (for example) an ID of -0.5 refers to position 0.  Reading an input that was not
+ *  provided gives 0.0; outputs that were never written are 0.0.  Outputs with IDs from 0 to
+ *  MAX_OUTPUTS-1 are stored densely; any other ID (negative or large) goes into a sparse map,
+ *  so every output AvidaGP would record is kept.  Register values outside the range of int
+ *  (and NaN) become INT_MIN, which is what an (int) cast produces on x86.
+ *
+ *  Execution state is held separately (in a CompiledAvidaGP::State) so that a single state
+ *  object can be reused across many programs and evaluations.
+ */
+
+#ifndef MABE_TOOL_COMPILED_AVIDA_GP_H
+#define MABE_TOOL_COMPILED_AVIDA_GP_H
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "emp/base/assert.hpp"
+#include "emp/base/vector.hpp"
+#include "emp/math/math.hpp"
+
+namespace mabe {
+
+  class CompiledAvidaGP {
+  public:
+    static constexpr size_t CPU_SIZE = 16;      ///< Number of registers, stacks, scopes, etc.
+    static constexpr size_t STACK_CAP = 16;     ///< Maximum size of each stack.
+    static constexpr size_t MAX_OUTPUTS = 256;  ///< Output IDs stored densely (others are sparse).
+
+    enum Op : uint8_t {
+      OP_INC=0, OP_DEC, OP_NOT, OP_SET_REG, OP_ADD, OP_SUB, OP_MULT, OP_DIV, OP_MOD,
+      OP_TEST_EQU, OP_TEST_NEQU, OP_TEST_LESS, OP_IF, OP_WHILE, OP_COUNTDOWN, OP_BREAK,
+      OP_SCOPE, OP_DEFINE, OP_CALL, OP_PUSH, OP_POP, OP_INPUT, OP_OUTPUT, OP_COPY_VAL,
+      OP_SCOPE_REG,
+      NUM_OPS,
+      OP_INTRON=NUM_OPS,   ///< Compiled only: instruction that cannot affect outputs.
+      OP_UNKNOWN=255
+    };
+
+    enum ScopeType : uint8_t { SCOPE_NONE=0, SCOPE_ROOT, SCOPE_BASIC, SCOPE_LOOP, SCOPE_FUNCTION };
+
+    /// A single pre-decoded instruction.
+    struct Inst {
+      uint8_t op = OP_INC;
+      uint8_t args[3] = {0, 0, 0};
+    };
+
+    /// All of the dynamic state needed to run a program.
+    struct State {
+      struct ScopeInfo {
+        size_t scope;
+        ScopeType type;
+        size_t start_pos;
+      };
+      struct RegBackup {
+        size_t scope;
+        size_t reg_id;
+        double value;
+      };
+
+      double regs[CPU_SIZE];
+      double stacks[CPU_SIZE][STACK_CAP];
+      size_t stack_size[CPU_SIZE];
+      int fun_starts[CPU_SIZE];
+      emp::vector<double> inputs;
+      emp::vector<double> outputs;                      ///< Outputs with IDs in [0, MAX_OUTPUTS)
+      std::unordered_map<int, double> sparse_outputs;   ///< Outputs with any other ID.
+
+      size_t inst_ptr = 0;
+      emp::vector<ScopeInfo> scope_stack;
+      emp::vector<RegBackup> reg_stack;
+      emp::vector<size_t> call_stack;
+      size_t errors = 0;
+
+      State() { Reset(); }
+
+      /// Return to the starting state (inputs are cleared; capacity is kept for reuse).
+      void Reset() {
+        for (size_t i = 0; i < CPU_SIZE; i++) {
+          regs[i] = (double) i;
+          stack_size[i] = 0;
+          fun_starts[i] = -1;
+        }
+        inputs.resize(0);
+        outputs.resize(0);
+        sparse_outputs.clear();
+        inst_ptr = 0;
+        scope_stack.resize(0);
+        scope_stack.push_back(ScopeInfo{0, SCOPE_ROOT, 0});
+        reg_stack.resize(0);
+        call_stack.resize(0);
+        errors = 0;
+      }
+
+      void SetInputs(const emp::vector<double> & in) { inputs.assign(in.begin(), in.end()); }
+
+      /// Convert a register value to an ID the way AvidaGP's (int) cast does.
+      static int ToID(double id_val) {
+        const bool in_range = id_val > (double) INT_MIN - 1.0 && id_val < (double) INT_MAX + 1.0;
+        return in_range ? (int) id_val : INT_MIN;
+      }
+
+      double GetInput(double id_val) const {
+        const int id = ToID(id_val);
+        if (id < 0 || (size_t) id >= inputs.size()) return 0.0;
+        return inputs[(size_t) id];
+      }
+
+      void SetOutput(double id_val, double value) {
+        const int id = ToID(id_val);
+        if (id < 0 || (size_t) id >= MAX_OUTPUTS) {
+          sparse_outputs[id] = value;
+          return;
+        }
+        if ((size_t) id >= outputs.size()) outputs.resize((size_t) id + 1, 0.0);
+        outputs[(size_t) id] = value;
+      }
+
+      double GetOutput(int id) const {
+        if (id >= 0 && (size_t) id < outputs.size()) return outputs[(size_t) id];
+        if (id >= 0 && (size_t) id < MAX_OUTPUTS) return 0.0;
+        auto it = sparse_outputs.find(id);
+        return (it == sparse_outputs.end()) ? 0.0 : it->second;
+      }
+
+      /// Copy outputs into a vector indexed by ID (as emp::ToVector() does with AvidaGP's
+      /// output map); negative IDs cannot be placed and are left out.
+      void CopyOutputs(emp::vector<double> & out) const {
+        out = outputs;
+        if (sparse_outputs.empty()) return;
+        for (const auto & [id, value] : sparse_outputs) {
+          if (id < 0) continue;
+          if ((size_t) id >= out.size()) out.resize((size_t) id + 1, 0.0);
+          out[(size_t) id] = value;
+        }
+      }
+
+      size_t CurScope() const { return scope_stack.back().scope; }
+      ScopeType CurScopeType() const { return scope_stack.back().type; }
+    };
+
+    /// Translation from an instruction library's IDs to opcodes.  Filled in once by Setup();
+    /// lookups are read-only, so one map can be shared by threads compiling at the same time.
+    class OpMap {
+    private:
+      emp::vector<uint8_t> id_to_op;
+    public:
+      OpMap() = default;
+      template <typename INST_LIB_T>
+      OpMap(const INST_LIB_T & inst_lib) { Setup(inst_lib); }
+
+      /// Translate every instruction in the library.
+      template <typename INST_LIB_T>
+      void Setup(const INST_LIB_T & inst_lib) {
+        id_to_op.resize(inst_lib.GetSize());
+        for (size_t id = 0; id < id_to_op.size(); ++id) {
+          id_to_op[id] = NameToOp(inst_lib.GetName(id));
+        }
+      }
+
+      uint8_t GetOp(size_t id) const {
+        return (id < id_to_op.size()) ? id_to_op[id] : (uint8_t) OP_UNKNOWN;
+      }
+      void Clear() { id_to_op.resize(0); }
+    };
+
+  private:
+    emp::vector<Inst> code;          ///< The pre-decoded program.
+    emp::vector<uint8_t> inst_scope; ///< Scope level set by each instruction (0 = none)
+    emp::vector<size_t> next_scope;  ///< Next position (after this one) with a scope instruction.
+    emp::vector<uint32_t> intron_run; ///< Introns in a row starting at each position.
+    size_t num_effective = 0;        ///< Number of instructions that can affect outputs.
+    bool compiled = false;           ///< Is the current code valid?
+
+    /// Which scope does an instruction move to?  (Scopes are one higher than their arg.)
+    static uint8_t CalcInstScope(const Inst & inst) {
+      switch (inst.op) {
+        case OP_IF: case OP_WHILE: case OP_COUNTDOWN: case OP_DEFINE: return inst.args[1] + 1;
+        case OP_SCOPE: return inst.args[0] + 1;
+        default: return 0;
+      }
+    }
+
+    /// Fill out helper tables once the code is in place.
+    void Finalize() {
+      const size_t size = code.size();
+      inst_scope.resize(size);
+      next_scope.resize(size);
+      size_t next = size;
+      for (size_t pos = size; pos > 0; --pos) {
+        next_scope[pos-1] = next;
+        inst_scope[pos-1] = CalcInstScope(code[pos-1]);
+        if (inst_scope[pos-1]) next = pos-1;
+      }
+      compiled = true;
+    }
+
+    /// Find instructions that cannot affect outputs, mark them as introns, and record the
+    /// length of each run of them so Process() can skip over a run at once.  Function calls make
+    /// the control flow dynamic, so the analysis ignores instruction order: a register or stack
+    /// is live if any effective instruction reads it, and an instruction is effective if it may
+    /// write something live.  Outputs and all scope-related instructions are always effective.
+    void MarkIntrons() {
+      const size_t size = code.size();
+      constexpr uint32_t ALWAYS = (uint32_t) -1;   // Marker for instructions that must be kept.
+      auto reg = [](size_t id) { return 1u << id; };
+      auto stack = [](size_t id) { return 1u << (CPU_SIZE + id); };
+      static_assert(CPU_SIZE * 2 <= 32, "Registers and stacks must fit in a 32-bit mask.");
+
+      emp::vector<uint32_t> uses(size, 0), defs(size, 0);
+      for (size_t pos = 0; pos < size; ++pos) {
+        const size_t a0 = code[pos].args[0], a1 = code[pos].args[1], a2 = code[pos].args[2];
+        switch (code[pos].op) {
+        case OP_INC: case OP_DEC: case OP_NOT: uses[pos] = defs[pos] = reg(a0); break;
+        case OP_SET_REG:   defs[pos] = reg(a0); break;
+        case OP_ADD: case OP_SUB: case OP_MULT: case OP_DIV: case OP_MOD:
+        case OP_TEST_EQU: case OP_TEST_NEQU: case OP_TEST_LESS:
+          uses[pos] = reg(a0) | reg(a1); defs[pos] = reg(a2); break;
+        case OP_PUSH:      uses[pos] = reg(a0); defs[pos] = stack(a1); break;
+        case OP_POP:       uses[pos] = stack(a0); defs[pos] = reg(a1) | stack(a0); break;
+        case OP_INPUT:     uses[pos] = reg(a0); defs[pos] = reg(a1); break;
+        case OP_COPY_VAL:  uses[pos] = reg(a0); defs[pos] = reg(a1); break;
+        case OP_SCOPE_REG: uses[pos] = defs[pos] = reg(a0); break;   // Restored on scope exit.
+        case OP_OUTPUT:    uses[pos] = reg(a0) | reg(a1); defs[pos] = ALWAYS; break;
+        case OP_IF: case OP_WHILE: case OP_COUNTDOWN:
+          uses[pos] = reg(a0); defs[pos] = ALWAYS; break;
+        default:           defs[pos] = ALWAYS;   // Break, Scope, Define, Call
+        }
+      }
+
+      uint32_t live = 0;
+      bool changed = true;
+      while (changed) {
+        changed = false;
+        for (size_t pos = 0; pos < size; ++pos) {
+          if ((defs[pos] == ALWAYS || (defs[pos] & live)) && (live | uses[pos]) != live) {
+            live |= uses[pos];
+            changed = true;
+          }
+        }
+      }
+
+      intron_run.resize(size);
+      num_effective = 0;
+      uint32_t run_length = 0;
+      for (size_t pos = size; pos > 0; --pos) {
+        const size_t i = pos - 1;
+        if (defs[i] == ALWAYS || (defs[i] & live)) {
+          run_length = 0;
+          ++num_effective;
+        }
+        else {
+          code[i].op = OP_INTRON;
+          ++run_length;
+        }
+        intron_run[i] = run_length;
+      }
+    }
+
+    // --- Scope handling ---
+
+    void ExitScope(State & state) const {
+      emp_assert(state.scope_stack.size() > 1, state.CurScope());
+      // Restore any backed-up registers from this scope.
+      const size_t cur_scope = state.CurScope();
+      while (state.reg_stack.size() && state.reg_stack.back().scope == cur_scope) {
+        state.regs[state.reg_stack.back().reg_id] = state.reg_stack.back().value;
+        state.reg_stack.pop_back();
+      }
+      state.scope_stack.pop_back();
+    }
+
+    /// Move the instruction pointer back to the beginning, clearing out all scopes.
+    void ResetIP(State & state) const {
+      state.inst_ptr = 0;
+      while (state.scope_stack.size() > 1) ExitScope(state);
+      while (state.reg_stack.size()) {
+        state.regs[state.reg_stack.back().reg_id] = state.reg_stack.back().value;
+        state.reg_stack.pop_back();
+      }
+      state.call_stack.resize(0);
+    }
+
+    /// Move into a new scope; return false if the current instruction should NOT be run because
+    /// a prior scope (a loop or function) needs to be returned to instead.
+    bool UpdateScope(State & state, size_t new_scope, ScopeType type) const {
+      new_scope++;  // Scopes are stored as one higher than their arguments (root is 0)
+
+      while (true) {
+        // Entering a deeper scope?
+        if (new_scope > state.CurScope()) {
+          state.scope_stack.push_back(State::ScopeInfo{new_scope, type, state.inst_ptr});
+          return true;
+        }
+
+        // Exiting a loop?  Go back to the start and run the loop instruction again.
+        if (state.CurScopeType() == SCOPE_LOOP) {
+          state.inst_ptr = state.scope_stack.back().start_pos;
+          ExitScope(state);
+          Execute(state, code[state.inst_ptr]);
+          return false;
+        }
+
+        // Exiting a function?  Return to the call point and run the instruction there.
+        if (state.CurScopeType() == SCOPE_FUNCTION) {
+          emp_assert(state.call_stack.size() > 0);
+          state.inst_ptr = state.call_stack.back();
+          state.call_stack.pop_back();
+          ExitScope(state);
+          if (state.inst_ptr >= code.size()) ResetIP(state);  // Call may have been at the end.
+          Execute(state, code[state.inst_ptr]);
+          return false;
+        }
+
+        // Otherwise, simply exit the current scope and test again.
+        ExitScope(state);
+      }
+    }
+
+    /// Skip past the end of the specified scope.
+    void BypassScope(State & state, size_t scope) const {
+      scope++;                                   // Scopes are stored as one higher.
+      if (state.CurScope() < scope) return;      // Only relevant if we are in this scope.
+      while (state.CurScope() >= scope) ExitScope(state);
+
+      // Find the next instruction that starts a scope at this level or outside of it.
+      size_t pos = next_scope[state.inst_ptr];
+      while (pos < code.size() && inst_scope[pos] > scope) pos = next_scope[pos];
+      state.inst_ptr = (pos < code.size()) ? pos - 1 : code.size() - 1;
+    }
+
+    void Execute(State & state, const Inst & inst) const {
+      double * regs = state.regs;
+      const size_t a0 = inst.args[0], a1 = inst.args[1], a2 = inst.args[2];
+
+      switch (inst.op) {
+      case OP_INC:       ++regs[a0]; break;
+      case OP_DEC:       --regs[a0]; break;
+      case OP_NOT:       regs[a0] = (regs[a0] == 0.0); break;
+      case OP_SET_REG:   regs[a0] = (double) a1; break;
+      case OP_ADD:       regs[a2] = regs[a0] + regs[a1]; break;
+      case OP_SUB:       regs[a2] = regs[a0] - regs[a1]; break;
+      case OP_MULT:      regs[a2] = regs[a0] * regs[a1]; break;
+      case OP_DIV:
+        if (regs[a1] == 0.0) ++state.errors;
+        else regs[a2] = regs[a0] / regs[a1];
+        break;
+      case OP_MOD:
+        if (regs[a1] == 0.0) ++state.errors;
+        else regs[a2] = emp::Mod(regs[a0], regs[a1]);
+        break;
+      case OP_TEST_EQU:  regs[a2] = (regs[a0] == regs[a1]); break;
+      case OP_TEST_NEQU: regs[a2] = (regs[a0] != regs[a1]); break;
+      case OP_TEST_LESS: regs[a2] = (regs[a0] < regs[a1]); break;
+      case OP_IF:
+        if (UpdateScope(state, a1, SCOPE_BASIC) == false) break;
+        if (regs[a0] == 0.0) BypassScope(state, a1);
+        break;
+      case OP_WHILE:
+        if (UpdateScope(state, a1, SCOPE_LOOP) == false) break;
+        if (regs[a0] == 0.0) BypassScope(state, a1);
+        break;
+      case OP_COUNTDOWN:
+        if (UpdateScope(state, a1, SCOPE_LOOP) == false) break;
+        if (regs[a0] == 0.0) BypassScope(state, a1);
+        else --regs[a0];
+        break;
+      case OP_BREAK:     BypassScope(state, a0); break;
+      case OP_SCOPE:     UpdateScope(state, a0, SCOPE_BASIC); break;
+      case OP_DEFINE:
+        if (UpdateScope(state, a1, SCOPE_BASIC) == false) break;
+        state.fun_starts[a0] = (int) state.inst_ptr;
+        BypassScope(state, a1);
+        break;
+      case OP_CALL: {
+        // Make sure the function exists and is still in place.
+        const size_t def_pos = (size_t) state.fun_starts[a0];
+        if (def_pos >= code.size() || code[def_pos].op != OP_DEFINE) break;
+
+        // Go back into the function's original scope (call is in that scope).
+        if (UpdateScope(state, code[def_pos].args[1], SCOPE_FUNCTION) == false) break;
+        state.call_stack.push_back(state.inst_ptr+1);
+        state.inst_ptr = def_pos;  // Body starts on next instruction.
+        break;
+      }
+      case OP_PUSH:
+        if (state.stack_size[a1] < STACK_CAP) state.stacks[a1][state.stack_size[a1]++] = regs[a0];
+        break;
+      case OP_POP:
+        regs[a1] = state.stack_size[a0] ? state.stacks[a0][--state.stack_size[a0]] : 0.0;
+        break;
+      case OP_INPUT:     regs[a1] = state.GetInput(regs[a0]); break;
+      case OP_OUTPUT:    state.SetOutput(regs[a1], regs[a0]); break;
+      case OP_COPY_VAL:  regs[a1] = regs[a0]; break;
+      case OP_SCOPE_REG:
+        state.reg_stack.push_back(State::RegBackup{state.CurScope(), a0, regs[a0]});
+        break;
+      case OP_INTRON:    break;   // Only reached when returning from a function.
+      default:
+        emp_assert(false, "Unknown compiled AvidaGP op.", (size_t) inst.op);
+      }
+    }
+
+  public:
+    CompiledAvidaGP() = default;
+    CompiledAvidaGP(const CompiledAvidaGP &) = default;
+    CompiledAvidaGP(CompiledAvidaGP &&) = default;
+    CompiledAvidaGP & operator=(const CompiledAvidaGP &) = default;
+    CompiledAvidaGP & operator=(CompiledAvidaGP &&) = default;
+
+    /// Convert a standard AvidaGP instruction name to an opcode.
+    static uint8_t NameToOp(const std::string & name) {
+      static const std::string names[NUM_OPS] = {
+        "Inc", "Dec", "Not", "SetReg", "Add", "Sub", "Mult", "Div", "Mod",
+        "TestEqu", "TestNEqu", "TestLess", "If", "While", "Countdown", "Break",
+        "Scope", "Define", "Call", "Push", "Pop", "Input", "Output", "CopyVal",
+        "ScopeReg"
+      };
+      for (size_t op = 0; op < NUM_OPS; ++op) if (names[op] == name) return (uint8_t) op;
+      return OP_UNKNOWN;
+    }
+
+    bool IsCompiled() const { return compiled; }
+    size_t GetSize() const { return code.size(); }
+    size_t GetEffectiveSize() const { return num_effective; }
+    const emp::vector<Inst> & GetCode() const { return code; }
+
+    /// Mark the compiled code as out of date (e.g., after the genome has changed).
+    void Invalidate() { compiled = false; }
+
+    /// Translate a genome: any sequence of instructions with an instruction library "id" and
+    /// three "args", using an OpMap set up from the library the ids come from.  Returns false
+    /// (and remains uncompiled) if any instruction is not part of the standard set.  If
+    /// strip_introns is set, instructions that cannot affect outputs are skipped during
+    /// execution (but still take one CPU cycle each, so results are unchanged).
+    template <typename SEQUENCE_T>
+    bool Compile(const SEQUENCE_T & sequence, const OpMap & op_map, bool strip_introns=false) {
+      const size_t size = sequence.size();
+      compiled = false;
+      code.resize(size);
+      for (size_t pos = 0; pos < size; ++pos) {
+        const auto & inst = sequence[pos];
+        const uint8_t op = op_map.GetOp(inst.id);
+        if (op == OP_UNKNOWN) return false;
+        code[pos].op = op;
+        for (size_t i = 0; i < 3; ++i) {
+          emp_assert(inst.args[i] < CPU_SIZE, inst.args[i]);
+          code[pos].args[i] = (uint8_t) inst.args[i];
+        }
+      }
+      Finalize();
+      if (strip_introns) MarkIntrons();
+      else {
+        intron_run.resize(0);
+        num_effective = size;
+      }
+      return true;
+    }
+
+    /// Run the program for num_inst CPU cycles, starting from the current state.
+    void Process(State & state, size_t num_inst) const {
+      emp_assert(compiled);
+      const size_t size = code.size();
+      if (size == 0) return;
+      for (size_t i = 0; i < num_inst; ++i) {
+        if (state.inst_ptr >= size) ResetIP(state);
+        const Inst & inst = code[state.inst_ptr];
+        if (inst.op == OP_INTRON) {
+          // Pass the whole run of introns, using one cycle for each.
+          const size_t skip = std::min<size_t>(intron_run[state.inst_ptr], num_inst - i);
+          state.inst_ptr += skip;
+          i += skip - 1;
+          continue;
+        }
+        Execute(state, inst);
+        ++state.inst_ptr;
+      }
+    }
+
+    /// Reset the state, load inputs, and run the program for num_inst cycles.
+    void Run(State & state, const emp::vector<double> & inputs, size_t num_inst) const {
+      state.Reset();
+      state.SetInputs(inputs);
+      Process(state, num_inst);
+    }
+
+    /// Run the program once per input case, writing num_outputs values per case into out
+    /// (row-major).  The same state object is reset between cases without reallocating.
+    void RunBatch(State & state, const emp::vector<emp::vector<double>> & inputs,
+                  size_t num_inst, double * out, size_t num_outputs) const {
+      for (const emp::vector<double> & case_inputs : inputs) {
+        Run(state, case_inputs, num_inst);
+        const size_t num_set = std::min(num_outputs, state.outputs.size());
+        for (size_t i = 0; i < num_set; ++i) out[i] = state.outputs[i];
+        for (size_t i = num_set; i < num_outputs; ++i) out[i] = state.GetOutput((int) i);
+        out += num_outputs;
+      }
+    }
+  };
+
+}
+
+#endif
@@ -0,0 +1,501 @@
+/**
+ *  @note This file is part of MABE, https://github.com/mercere99/MABE2
+ *  @copyright Copyright (C) Michigan State University, MIT Software license; see doc/LICENSE.md
+ *  @date 2021.
+ *
+ *  @file  CopyOnWrite.hpp
+ *  @brief Reference-counted genome storage that is shared between relatives until modified.
+ *
+ *  Most offspring differ from their parent at zero or a handful of sites, so deep-copying
+ *  the whole genome on every birth is mostly wasted work.  Two containers are provided:
+ *
+ *  CopyOnWrite<T> shares a single object; it is only copied when Edit() is called while
+ *  another organism still refers to it.  Use it when the genome must remain contiguous
+ *  (e.g., a BitVector that is published to evaluators through a GenomeView).
+ *
+ *  SharedChunkVector<T, CHUNK_SIZE> splits a sequence into reference-counted chunks of up to
+ *  CHUNK_SIZE items.  Copying the vector copies only the chunk pointers; writing to a site
+ *  copies just the chunk that holds it (if it is shared).  Insert() and Erase() only shift
+ *  items within one chunk (splitting a full chunk or dropping an empty one) plus a small table
+ *  of chunk end positions, so insertion and deletion mutations do not move the rest of a long
+ *  genome.  Use CopyTo() or ForEachChunk() to linearize the sequence for execution.
+ *
+ *  Both keep global SharingStats for each stored type, so the sharing ratio (references per
+ *  allocated block) can be reported.  Reference counts are atomic, so organisms may be copied
+ *  and released on different threads; a single container must not be modified concurrently.
+ */
+
+#ifndef MABE_TOOL_COPY_ON_WRITE_H
+#define MABE_TOOL_COPY_ON_WRITE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <utility>
+
+#include "emp/base/assert.hpp"
+#include "emp/base/Ptr.hpp"
+#include "emp/base/vector.hpp"
+#include "emp/tools/string_utils.hpp"
+
+namespace mabe {
+
+  /// Counts of shared storage blocks in use, and how many references there are to them.
+  struct SharingStats {
+    std::atomic<size_t> num_blocks{0};   ///< Distinct blocks currently allocated.
+    std::atomic<size_t> num_refs{0};     ///< References to those blocks held by containers.
+    std::atomic<size_t> num_copies{0};   ///< Blocks ever copied because a shared one was edited.
+
+    /// Average number of references to each allocated block (1.0 = no sharing).
+    double GetRatio() const {
+      const size_t blocks = num_blocks;
+      return blocks ? ((double) num_refs) / (double) blocks : 1.0;
+    }
+
+    std::string ToString(const std::string & block_name="blocks") const {
+      return emp::to_string(num_refs.load(), " references to ", num_blocks.load(), " ", block_name,
+                            " (sharing ratio ", GetRatio(), "); ", num_copies.load(),
+                            " copied on write.");
+    }
+  };
+
+  template <typename T>
+  class CopyOnWrite {
+  private:
+    struct Block {
+      std::atomic<size_t> ref_count{1};
+      T value;
+
+      template <typename... ARG_Ts>
+      Block(ARG_Ts &&... args) : value(std::forward<ARG_Ts>(args)...) { }
+    };
+
+    emp::Ptr<Block> block = nullptr;
+
+    static emp::Ptr<Block> NewBlock(const T & value) {
+      ++GetStats().num_blocks;
+      ++GetStats().num_refs;
+      return emp::NewPtr<Block>(value);
+    }
+
+    void Release() {
+      if (!block) return;
+      --GetStats().num_refs;
+      if (--block->ref_count == 0) {
+        --GetStats().num_blocks;
+        block.Delete();
+      }
+      block = nullptr;
+    }
+
+  public:
+    CopyOnWrite() : block(NewBlock(T())) { }
+    CopyOnWrite(const T & value) : block(NewBlock(value)) { }
+    CopyOnWrite(const CopyOnWrite & in) : block(in.block) {
+      if (!block) return;
+      ++block->ref_count;
+      ++GetStats().num_refs;
+    }
+    CopyOnWrite(CopyOnWrite && in) : block(in.block) { in.block = nullptr; }
+    ~CopyOnWrite() { Release(); }
+
+    CopyOnWrite & operator=(const CopyOnWrite & in) {
+      if (block == in.block) return *this;
+      Release();
+      block = in.block;
+      if (block) {
+        ++block->ref_count;
+        ++GetStats().num_refs;
+      }
+      return *this;
+    }
+    CopyOnWrite & operator=(CopyOnWrite && in) {
+      if (this == &in) return *this;
+      Release();
+      block = in.block;
+      in.block = nullptr;
+      return *this;
+    }
+
+    /// Stats shared by all CopyOnWrite objects holding this type.
+    static SharingStats & GetStats() {
+      static SharingStats stats;
+      return stats;
+    }
+
+    /// Is the held object also in use by another container?
+    bool IsShared() const { return block->ref_count > 1; }
+
+    const T & Get() const { emp_assert(block); return block->value; }
+    const T & operator*() const { return Get(); }
+    const T * operator->() const { return &Get(); }
+
+    /// Get a modifiable reference, first making a private copy if the object is shared.
+    /// Any previously held references to the value may be invalidated.
+    T & Edit() {
+      emp_assert(block);
+      if (IsShared()) {
+        emp::Ptr<Block> new_block = NewBlock(block->value);
+        ++GetStats().num_copies;
+        Release();
+        block = new_block;
+      }
+      return block->value;
+    }
+
+    void Set(const T & value) {
+      if (IsShared()) {
+        Release();
+        block = NewBlock(value);
+      }
+      else block->value = value;
+    }
+
+    bool operator==(const CopyOnWrite & in) const { return block == in.block || Get() == in.Get(); }
+    bool operator!=(const CopyOnWrite & in) const { return !(*this == in); }
+  };
+
+
+  template <typename T, size_t CHUNK_SIZE=64>
+  class SharedChunkVector {
+  private:
+    static_assert(CHUNK_SIZE > 1, "SharedChunkVector chunks must hold more than one item.");
+
+    struct Chunk {
+      std::atomic<size_t> ref_count{1};
+      T data[CHUNK_SIZE] = {};
+    };
+
+    emp::vector<emp::Ptr<Chunk>> chunks;  ///< Chunks in sequence order; none are empty.
+    emp::vector<size_t> chunk_end;        ///< Position just past the last item in each chunk.
+    size_t num_items = 0;                 ///< Number of positions in use.
+    bool packed = true;                   ///< Are all chunks (except the last) full?
+
+    static constexpr size_t NumChunks(size_t items) { return (items + CHUNK_SIZE - 1) / CHUNK_SIZE; }
+
+    static emp::Ptr<Chunk> NewChunk() {
+      ++GetStats().num_blocks;
+      ++GetStats().num_refs;
+      return emp::NewPtr<Chunk>();
+    }
+
+    static void Release(emp::Ptr<Chunk> chunk) {
+      --GetStats().num_refs;
+      if (--chunk->ref_count == 0) {
+        --GetStats().num_blocks;
+        chunk.Delete();
+      }
+    }
+
+    void ReleaseAll() {
+      for (emp::Ptr<Chunk> chunk : chunks) Release(chunk);
+      chunks.resize(0);
+      chunk_end.resize(0);
+    }
+
+    void ShareAll() {
+      for (emp::Ptr<Chunk> chunk : chunks) ++chunk->ref_count;
+      GetStats().num_refs += chunks.size();
+    }
+
+    size_t ChunkStart(size_t chunk_id) const { return chunk_id ? chunk_end[chunk_id-1] : 0; }
+    size_t ChunkFill(size_t chunk_id) const { return chunk_end[chunk_id] - ChunkStart(chunk_id); }
+
+    /// Find the chunk holding a position; packed vectors can compute it directly.
+    size_t FindChunk(size_t pos) const {
+      if (packed) return pos / CHUNK_SIZE;
+      return (size_t) (std::upper_bound(chunk_end.begin(), chunk_end.end(), pos) - chunk_end.begin());
+    }
+
+    /// Shift the end of all chunks from chunk_id onward (after an insertion or deletion).
+    void ShiftEnds(size_t chunk_id, int shift) {
+      for (size_t i = chunk_id; i < chunk_end.size(); ++i) chunk_end[i] += shift;
+      num_items += shift;
+    }
+
+    /// Make sure the chunk with the given ID is used only by this vector (copying it if not).
+    Chunk & MakeUnique(size_t chunk_id) {
+      emp::Ptr<Chunk> & chunk = chunks[chunk_id];
+      if (chunk->ref_count > 1) {
+        emp::Ptr<Chunk> new_chunk = NewChunk();
+        std::copy(chunk->data, chunk->data + ChunkFill(chunk_id), new_chunk->data);
+        ++GetStats().num_copies;
+        Release(chunk);
+        chunk = new_chunk;
+      }
+      return *chunk;
+    }
+
+    /// Move the back half of a full chunk into a new chunk that follows it.
+    void SplitChunk(size_t chunk_id) {
+      const size_t start = ChunkStart(chunk_id);
+      const size_t keep = CHUNK_SIZE / 2;
+      emp::Ptr<Chunk> new_chunk = NewChunk();
+      const T * old_data = chunks[chunk_id]->data;
+      std::copy(old_data + keep, old_data + CHUNK_SIZE, new_chunk->data);
+      chunks.insert(chunks.begin() + chunk_id + 1, new_chunk);
+      chunk_end.insert(chunk_end.begin() + chunk_id, start + keep);
+      packed = false;
+    }
+
+    /// Remove a chunk that has become empty, or fold a small chunk's successor into it.
+    void TidyChunk(size_t chunk_id) {
+      const size_t fill = ChunkFill(chunk_id);
+      if (fill == 0) {
+        Release(chunks[chunk_id]);
+        chunks.erase(chunks.begin() + chunk_id);
+        chunk_end.erase(chunk_end.begin() + chunk_id);
+        return;
+      }
+      if (fill >= CHUNK_SIZE / 4 || chunk_id + 1 >= chunks.size()) return;
+      const size_t next_fill = ChunkFill(chunk_id + 1);
+      if (fill + next_fill > CHUNK_SIZE) return;
+      Chunk & chunk = MakeUnique(chunk_id);
+      const T * next_data = chunks[chunk_id+1]->data;
+      std::copy(next_data, next_data + next_fill, chunk.data + fill);
+      Release(chunks[chunk_id+1]);
+      chunks.erase(chunks.begin() + chunk_id + 1);
+      chunk_end.erase(chunk_end.begin() + chunk_id);
+    }
+
+  public:
+    using value_type = T;
+
+    /// Read-only iterator through all positions (writes must go through Set() or Edit()).
+    class const_iterator {
+    private:
+      const SharedChunkVector * vec;
+      size_t chunk_id;
+      size_t offset;
+    public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = T;
+      using difference_type = std::ptrdiff_t;
+      using pointer = const T *;
+      using reference = const T &;
+
+      const_iterator(const SharedChunkVector * _vec, size_t _chunk_id)
+        : vec(_vec), chunk_id(_chunk_id), offset(0) { }
+      const T & operator*() const { return vec->chunks[chunk_id]->data[offset]; }
+      const T * operator->() const { return &(vec->chunks[chunk_id]->data[offset]); }
+      const_iterator & operator++() {
+        if (++offset == vec->ChunkFill(chunk_id)) { ++chunk_id; offset = 0; }
+        return *this;
+      }
+      bool operator==(const const_iterator & in) const {
+        return chunk_id == in.chunk_id && offset == in.offset;
+      }
+      bool operator!=(const const_iterator & in) const { return !(*this == in); }
+    };
+
+    SharedChunkVector() = default;
+    SharedChunkVector(size_t in_size, const T & value=T()) { resize(in_size, value); }
+    SharedChunkVector(const emp::vector<T> & in) { Assign(in); }
+    SharedChunkVector(const SharedChunkVector & in)
+      : chunks(in.chunks), chunk_end(in.chunk_end), num_items(in.num_items), packed(in.packed)
+    {
+      ShareAll();
+    }
+    SharedChunkVector(SharedChunkVector && in)
+      : chunks(std::move(in.chunks)), chunk_end(std::move(in.chunk_end))
+      , num_items(in.num_items), packed(in.packed)
+    {
+      in.chunks.resize(0);
+      in.chunk_end.resize(0);
+      in.num_items = 0;
+      in.packed = true;
+    }
+    ~SharedChunkVector() { ReleaseAll(); }
+
+    SharedChunkVector & operator=(const SharedChunkVector & in) {
+      if (this == &in) return *this;
+      ReleaseAll();
+      chunks = in.chunks;
+      chunk_end = in.chunk_end;
+      num_items = in.num_items;
+      packed = in.packed;
+      ShareAll();
+      return *this;
+    }
+    SharedChunkVector & operator=(SharedChunkVector && in) {
+      if (this == &in) return *this;
+      ReleaseAll();
+      chunks = std::move(in.chunks);
+      chunk_end = std::move(in.chunk_end);
+      num_items = in.num_items;
+      packed = in.packed;
+      in.chunks.resize(0);
+      in.chunk_end.resize(0);
+      in.num_items = 0;
+      in.packed = true;
+      return *this;
+    }
+
+    /// Stats shared by all SharedChunkVectors holding this type (with this chunk size).
+    static SharingStats & GetStats() {
+      static SharingStats stats;
+      return stats;
+    }
+
+    static constexpr size_t GetChunkSize() { return CHUNK_SIZE; }
+
+    size_t size() const { return num_items; }
+    bool empty() const { return num_items == 0; }
+    size_t GetNumChunks() const { return chunks.size(); }
+
+    /// Is the chunk holding the given position also in use by another vector?
+    bool IsShared(size_t pos) const { return chunks[FindChunk(pos)]->ref_count > 1; }
+
+    const T & operator[](size_t pos) const {
+      emp_assert(pos < num_items, pos, num_items);
+      const size_t chunk_id = FindChunk(pos);
+      return chunks[chunk_id]->data[pos - ChunkStart(chunk_id)];
+    }
+    const T & Get(size_t pos) const { return (*this)[pos]; }
+
+    /// Get a modifiable reference to a position, copying its chunk first if it is shared.
+    /// References to other positions in the same chunk may be invalidated.
+    T & Edit(size_t pos) {
+      emp_assert(pos < num_items, pos, num_items);
+      const size_t chunk_id = FindChunk(pos);
+      return MakeUnique(chunk_id).data[pos - ChunkStart(chunk_id)];
+    }
+    void Set(size_t pos, const T & value) { Edit(pos) = value; }
+
+    /// Insert a value before the given position; only the chunk it lands in is shifted (or
+    /// split, if full).
+    void Insert(size_t pos, const T & value) {
+      emp_assert(pos <= num_items, pos, num_items);
+      if (chunks.empty()) {
+        chunks.push_back(NewChunk());
+        chunk_end.push_back(0);
+      }
+      // Positions at the end of a chunk are added to that chunk, not the start of the next.
+      size_t chunk_id = (pos == num_items) ? chunks.size() - 1 : FindChunk(pos);
+      if (pos == ChunkStart(chunk_id) && chunk_id > 0 && ChunkFill(chunk_id-1) < CHUNK_SIZE) {
+        --chunk_id;
+      }
+      if (ChunkFill(chunk_id) == CHUNK_SIZE) {
+        MakeUnique(chunk_id);   // Make sure the half we keep is private before splitting.
+        SplitChunk(chunk_id);
+        if (pos > chunk_end[chunk_id]) ++chunk_id;
+      }
+      else if (chunk_id + 1 < chunks.size()) packed = false;
+
+      Chunk & chunk = MakeUnique(chunk_id);
+      const size_t offset = pos - ChunkStart(chunk_id);
+      const size_t fill = ChunkFill(chunk_id);
+      std::copy_backward(chunk.data + offset, chunk.data + fill, chunk.data + fill + 1);
+      chunk.data[offset] = value;
+      ShiftEnds(chunk_id, 1);
+    }
+
+    /// Remove the value at the given position; only the chunk holding it is shifted.
+    void Erase(size_t pos) {
+      emp_assert(pos < num_items, pos, num_items);
+      const size_t chunk_id = FindChunk(pos);
+      Chunk & chunk = MakeUnique(chunk_id);
+      const size_t offset = pos - ChunkStart(chunk_id);
+      std::copy(chunk.data + offset + 1, chunk.data + ChunkFill(chunk_id), chunk.data + offset);
+      ShiftEnds(chunk_id, -1);
+      if (chunk_id + 1 < chunks.size()) packed = false;
+      TidyChunk(chunk_id);
+    }
+
+    /// Change the number of positions; new positions are set to value.
+    void resize(size_t new_size, const T & value=T()) {
+      // Drop chunks past the new end.
+      if (new_size < num_items) {
+        const size_t keep = new_size ? FindChunk(new_size - 1) + 1 : 0;
+        for (size_t i = keep; i < chunks.size(); ++i) Release(chunks[i]);
+        chunks.resize(keep);
+        chunk_end.resize(keep);
+        if (keep) chunk_end.back() = new_size;
+        num_items = new_size;
+      }
+
+      // Fill out the last chunk, then add new ones as needed.
+      while (num_items < new_size) {
+        if (chunks.empty() || ChunkFill(chunks.size() - 1) == CHUNK_SIZE) {
+          chunks.push_back(NewChunk());
+          chunk_end.push_back(num_items);
+        }
+        const size_t chunk_id = chunks.size() - 1;
+        Chunk & chunk = MakeUnique(chunk_id);
+        const size_t fill = ChunkFill(chunk_id);
+        const size_t count = std::min(CHUNK_SIZE - fill, new_size - num_items);
+        std::fill(chunk.data + fill, chunk.data + fill + count, value);
+        chunk_end.back() += count;
+        num_items += count;
+      }
+      if (chunks.empty()) packed = true;
+    }
+    void clear() { resize(0); }
+
+    /// Replace all contents with those of a standard vector (no sharing with old chunks).
+    void Assign(const emp::vector<T> & in) {
+      ReleaseAll();
+      num_items = in.size();
+      packed = true;
+      chunks.resize(NumChunks(num_items));
+      chunk_end.resize(chunks.size());
+      for (size_t chunk_id = 0; chunk_id < chunks.size(); ++chunk_id) {
+        chunks[chunk_id] = NewChunk();
+        const size_t start = chunk_id * CHUNK_SIZE;
+        const size_t count = std::min(CHUNK_SIZE, num_items - start);
+        std::copy(in.begin() + start, in.begin() + start + count, chunks[chunk_id]->data);
+        chunk_end[chunk_id] = start + count;
+      }
+    }
+
+    /// Re-pack into full chunks (e.g., after many insertions and deletions).
+    void Compact() {
+      if (!packed) Assign(AsVector());
+    }
+
+    /// Linearize the contents into a standard vector (e.g., for execution).
+    void CopyTo(emp::vector<T> & out) const {
+      out.resize(num_items);
+      T * out_ptr = out.data();
+      ForEachChunk([&out_ptr](const T * data, size_t count){
+        out_ptr = std::copy(data, data + count, out_ptr);
+      });
+    }
+
+    emp::vector<T> AsVector() const {
+      emp::vector<T> out;
+      CopyTo(out);
+      return out;
+    }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, chunks.size()); }
+
+    /// Call fun(const T * data, size_t count) on each chunk in order; faster than indexing.
+    template <typename FUN_T>
+    void ForEachChunk(FUN_T && fun) const {
+      for (size_t chunk_id = 0; chunk_id < chunks.size(); ++chunk_id) {
+        fun(chunks[chunk_id]->data, ChunkFill(chunk_id));
+      }
+    }
+
+    /// Vectors are equal if their contents are; shared chunks are not compared element-wise.
+    bool operator==(const SharedChunkVector & in) const {
+      if (num_items != in.num_items) return false;
+      if (chunk_end != in.chunk_end) return std::equal(begin(), end(), in.begin());
+      for (size_t chunk_id = 0; chunk_id < chunks.size(); ++chunk_id) {
+        if (chunks[chunk_id] == in.chunks[chunk_id]) continue;
+        const T * a = chunks[chunk_id]->data;
+        const T * b = in.chunks[chunk_id]->data;
+        for (size_t i = 0; i < ChunkFill(chunk_id); ++i) if (!(a[i] == b[i])) return false;
+      }
+      return true;
+    }
+    bool operator!=(const SharedChunkVector & in) const { return !(*this == in); }
+  };
+
+}
+
+#endif
@@ -0,0 +1,93 @@
+/**
+ *  @note This file is part of MABE, https://github.com/mercere99/MABE2
+ *  @copyright Copyright (C) Michigan State University, MIT Software license; see doc/LICENSE.md
+ *  @date 2021.
+ *
+ *  @file  Crossover.hpp
+ *  @brief Helpers for recombining two linear genomes.
+ *
+ *  Crossover is described by a set of sorted cut points; the offspring takes sites from the
+ *  first parent up to the first cut, from the second parent up to the next cut, and so on.
+ *  Rather than deciding site-by-site, organisms should use these points to build a bit mask
+ *  (so bit genomes can be blended a word at a time) or to copy whole slices of a vector.
+ */
+
+#ifndef MABE_TOOL_CROSSOVER_H
+#define MABE_TOOL_CROSSOVER_H
+
+#include <algorithm>
+#include <cstdint>
+
+#include "emp/base/vector.hpp"
+#include "emp/bits/BitVector.hpp"
+#include "emp/math/Random.hpp"
+
+namespace mabe {
+
+  /// Ways that two genomes can be recombined.
+  enum CrossoverType {
+    CROSS_UNIFORM=0,   // Each site is independently taken from either parent.
+    CROSS_ONE_POINT,   // A single cut point; swap parents after it.
+    CROSS_K_POINT      // Several cut points; alternate parents between them.
+  };
+
+  /// Pick num_points distinct cut points in [1, size), returned in sorted order.
+  inline void PickCrossPoints(emp::Random & random, size_t size, size_t num_points,
+                              emp::vector<size_t> & points) {
+    points.resize(0);
+    if (size < 2) return;
+    num_points = std::min(num_points, size - 1);
+    while (points.size() < num_points) {
+      while (points.size() < num_points) points.push_back(1 + random.GetUInt(size - 1));
+      std::sort(points.begin(), points.end());
+      points.erase(std::unique(points.begin(), points.end()), points.end());
+    }
+  }
+
+  /// Build a mask of the given size where set bits mark sites to take from the second parent.
+  inline void BuildCrossMask(emp::Random & random, size_t size, CrossoverType type,
+                             size_t num_points, emp::BitVector & mask) {
+    mask.Resize(size);
+    if (type == CROSS_UNIFORM) {
+      mask.Randomize(random);
+      return;
+    }
+
+    thread_local emp::vector<size_t> points;
+    PickCrossPoints(random, size, (type == CROSS_ONE_POINT) ? 1 : num_points, points);
+    mask.Clear();
+    for (size_t i = 0; i < points.size(); i += 2) {
+      const size_t stop = (i + 1 < points.size()) ? points[i+1] : size;
+      mask.SetRange(points[i], stop);
+    }
+  }
+
+  /// Overwrite slices of a vector (between alternating cut points) with those of a second.
+  template <typename T>
+  void CrossVectors(emp::Random & random, const emp::vector<T> & parent2, CrossoverType type,
+                    size_t num_points, emp::vector<T> & offspring) {
+    const size_t size = std::min(offspring.size(), parent2.size());
+
+    // Uniform crossover uses one random bit per site, drawn 32 sites at a time.
+    if (type == CROSS_UNIFORM) {
+      for (size_t start = 0; start < size; start += 32) {
+        const uint32_t choice = random.GetUInt();
+        const size_t stop = std::min(size, start + 32);
+        for (size_t i = start; i < stop; ++i) {
+          if ((choice >> (i - start)) & 1) offspring[i] = parent2[i];
+        }
+      }
+      return;
+    }
+
+    thread_local emp::vector<size_t> points;
+    PickCrossPoints(random, size, (type == CROSS_ONE_POINT) ? 1 : num_points, points);
+    for (size_t i = 0; i < points.size(); i += 2) {
+      const size_t stop = (i + 1 < points.size()) ? points[i+1] : size;
+      std::copy(parent2.begin() + points[i], parent2.begin() + stop, offspring.begin() + points[i]);
+    }
+  }
+
+}
+
+#endif
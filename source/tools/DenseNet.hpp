@@ -0,0 +1,206 @@
+/**
+ *  @note This file is part of MABE, https://github.com/mercere99/MABE2
+ *  @copyright Copyright (C) Michigan State University, MIT Software license; see doc/LICENSE.md
+ *  @date 2021.
+ *
+ *  @file  DenseNet.hpp
+ *  @brief Forward passes for fully-connected (dense) feed-forward neural networks.
+ *
+ *  A DenseNet holds only the topology (layer sizes and activation functions); the parameters
+ *  are provided as a single contiguous array of doubles, so any organism can store them
+ *  however it likes.  For each layer (with n_in inputs and n_out outputs) the array holds
+ *  n_in * n_out weights stored input-major (all weights FROM input 0, then input 1, etc.)
+ *  followed by n_out biases.
+ *
+ *  Storing weights input-major means the inner loop of the forward pass adds a scaled weight
+ *  row into a row of accumulators.  Each iteration is independent, so the compiler can
+ *  vectorize it.  Batches are processed in blocks of BLOCK_CASES cases.  Each weight row is
+ *  used by every case in the block before moving on, and wide layers are tiled so that the
+ *  block's accumulators stay in cache.
+ */
+
+#ifndef MABE_TOOL_DENSE_NET_H
+#define MABE_TOOL_DENSE_NET_H
+
+#include <algorithm>
+#include <cmath>
+
+#include "emp/base/assert.hpp"
+#include "emp/base/vector.hpp"
+
+namespace mabe {
+
+  class DenseNet {
+  public:
+    enum Activation {
+      ACT_LINEAR=0,  // No change to values.
+      ACT_RELU,      // Negative values become zero.
+      ACT_TANH,      // Squash into (-1, 1).
+      ACT_SIGMOID    // Squash into (0, 1).
+    };
+
+    static constexpr size_t BLOCK_CASES = 16;   ///< Input cases evaluated together.
+    static constexpr size_t OUTPUT_TILE = 128;  ///< Max outputs accumulated at once per case.
+
+  private:
+    emp::vector<size_t> layer_sizes;     ///< Width of each layer, from inputs to outputs.
+    emp::vector<size_t> layer_offsets;   ///< Where each layer's parameters start.
+    size_t num_params = 0;               ///< Total number of weights and biases.
+    size_t max_width = 0;                ///< Size of the widest layer.
+    Activation hidden_act = ACT_TANH;    ///< Activation function for hidden layers.
+    Activation output_act = ACT_LINEAR;  ///< Activation function for the output layer.
+
+    static void Activate(Activation act, double * vals, size_t count) {
+      switch (act) {
+      case ACT_RELU:
+        for (size_t i = 0; i < count; ++i) vals[i] = std::max(vals[i], 0.0);
+        break;
+      case ACT_TANH:
+        for (size_t i = 0; i < count; ++i) vals[i] = std::tanh(vals[i]);
+        break;
+      case ACT_SIGMOID:
+        for (size_t i = 0; i < count; ++i) vals[i] = 1.0 / (1.0 + std::exp(-vals[i]));
+        break;
+      default:
+        break;
+      }
+    }
+
+    /// Run a single layer on a block of cases.  Both in and out are case-major with strides
+    /// equal to their layer widths.
+    void RunLayer(size_t layer, const double * params, const double * in, double * out,
+                  size_t num_cases) const {
+      const size_t n_in = layer_sizes[layer];
+      const size_t n_out = layer_sizes[layer+1];
+      const double * weights = params + layer_offsets[layer];
+      const double * biases = weights + n_in * n_out;
+
+      for (size_t tile_start = 0; tile_start < n_out; tile_start += OUTPUT_TILE) {
+        const size_t tile_size = std::min(OUTPUT_TILE, n_out - tile_start);
+
+        // Start each accumulator at its bias.
+        for (size_t c = 0; c < num_cases; ++c) {
+          std::copy(biases + tile_start, biases + tile_start + tile_size, out + c*n_out + tile_start);
+        }
+
+        // Add in each input's contribution; its weight row is reused across the whole block,
+        // and each weight loaded is applied to four cases at once.
+        for (size_t i = 0; i < n_in; ++i) {
+          const double * w_row = weights + i * n_out + tile_start;
+          size_t c = 0;
+          for (; c + 4 <= num_cases; c += 4) {
+            const double x0 = in[c * n_in + i];
+            const double x1 = in[(c+1) * n_in + i];
+            const double x2 = in[(c+2) * n_in + i];
+            const double x3 = in[(c+3) * n_in + i];
+            double * acc0 = out + c * n_out + tile_start;
+            double * acc1 = acc0 + n_out;
+            double * acc2 = acc1 + n_out;
+            double * acc3 = acc2 + n_out;
+            for (size_t j = 0; j < tile_size; ++j) {
+              const double w = w_row[j];
+              acc0[j] += x0 * w;
+              acc1[j] += x1 * w;
+              acc2[j] += x2 * w;
+              acc3[j] += x3 * w;
+            }
+          }
+          for (; c < num_cases; ++c) {
+            const double x = in[c * n_in + i];
+            double * acc = out + c * n_out + tile_start;
+            for (size_t j = 0; j < tile_size; ++j) acc[j] += x * w_row[j];
+          }
+        }
+      }
+
+      const bool is_output = (layer + 2 == layer_sizes.size());
+      Activate(is_output ? output_act : hidden_act, out, num_cases * n_out);
+    }
+
+    /// Run the whole network on a block of cases; return a pointer to the outputs (case-major).
+    const double * RunBlock(const double * params, const emp::vector<double> * const * inputs,
+                            size_t num_cases) const {
+      emp_assert(num_cases <= BLOCK_CASES);
+      thread_local emp::vector<double> buffer_a, buffer_b;
+      buffer_a.resize(BLOCK_CASES * max_width);
+      buffer_b.resize(BLOCK_CASES * max_width);
+      double * cur = buffer_a.data();
+      double * next = buffer_b.data();
+
+      // Load inputs; missing values are zero and extras are ignored.
+      const size_t n_in = GetNumInputs();
+      for (size_t c = 0; c < num_cases; ++c) {
+        const emp::vector<double> & case_in = *inputs[c];
+        const size_t count = std::min(n_in, case_in.size());
+        std::copy(case_in.begin(), case_in.begin() + count, cur + c * n_in);
+        std::fill(cur + c * n_in + count, cur + (c+1) * n_in, 0.0);
+      }
+
+      for (size_t layer = 0; layer + 1 < layer_sizes.size(); ++layer) {
+        RunLayer(layer, params, cur, next, num_cases);
+        std::swap(cur, next);
+      }
+      return cur;
+    }
+
+  public:
+    /// Set the layer sizes (inputs first, outputs last); returns false if fewer than two layers
+    /// or any layer is empty.
+    bool Setup(const emp::vector<size_t> & sizes, Activation hidden=ACT_TANH,
+               Activation output=ACT_LINEAR) {
+      if (sizes.size() < 2) return false;
+      for (size_t size : sizes) if (size == 0) return false;
+      layer_sizes = sizes;
+      hidden_act = hidden;
+      output_act = output;
+      layer_offsets.resize(sizes.size() - 1);
+      num_params = 0;
+      for (size_t layer = 0; layer + 1 < sizes.size(); ++layer) {
+        layer_offsets[layer] = num_params;
+        num_params += (sizes[layer] + 1) * sizes[layer+1];
+      }
+      max_width = *std::max_element(sizes.begin(), sizes.end());
+      return true;
+    }
+
+    size_t GetNumParams() const { return num_params; }
+    size_t GetNumInputs() const { return layer_sizes.size() ? layer_sizes[0] : 0; }
+    size_t GetNumOutputs() const { return layer_sizes.size() ? layer_sizes.back() : 0; }
+    size_t GetNumLayers() const { return layer_offsets.size(); }   ///< Layers of weights.
+    size_t GetLayerInputs(size_t layer) const { return layer_sizes[layer]; }
+    size_t GetLayerOutputs(size_t layer) const { return layer_sizes[layer+1]; }
+    size_t GetLayerOffset(size_t layer) const { return layer_offsets[layer]; }
+    size_t GetNumWeights(size_t layer) const { return layer_sizes[layer] * layer_sizes[layer+1]; }
+
+    /// Run the network on one set of inputs, writing num_outputs values (extras are zero).
+    void Forward(const double * params, const emp::vector<double> & inputs,
+                 double * outputs, size_t num_outputs) const {
+      const emp::vector<double> * input_ptr = &inputs;
+      const double * result = RunBlock(params, &input_ptr, 1);
+      const size_t count = std::min(num_outputs, GetNumOutputs());
+      std::copy(result, result + count, outputs);
+      std::fill(outputs + count, outputs + num_outputs, 0.0);
+    }
+
+    /// Run the network on many input cases, writing a case-by-output matrix (row-major).
+    void ForwardBatch(const double * params, const emp::vector<emp::vector<double>> & inputs,
+                      double * outputs, size_t num_outputs) const {
+      const size_t n_out = GetNumOutputs();
+      const size_t count = std::min(num_outputs, n_out);
+      const emp::vector<double> * block_inputs[BLOCK_CASES];
+      for (size_t start = 0; start < inputs.size(); start += BLOCK_CASES) {
+        const size_t num_cases = std::min(BLOCK_CASES, inputs.size() - start);
+        for (size_t c = 0; c < num_cases; ++c) block_inputs[c] = &inputs[start + c];
+        const double * result = RunBlock(params, block_inputs, num_cases);
+        for (size_t c = 0; c < num_cases; ++c) {
+          double * case_out = outputs + (start + c) * num_outputs;
+          std::copy(result + c * n_out, result + c * n_out + count, case_out);
+          std::fill(case_out + count, case_out + num_outputs, 0.0);
+        }
+      }
+    }
+  };
+
+}
+
+#endif
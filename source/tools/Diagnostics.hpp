@@ -0,0 +1,156 @@
+/**
+ *  @note This file is part of MABE, https://github.com/mercere99/MABE2
+ *  @copyright Copyright (C) Michigan State University, MIT Software license; see doc/LICENSE.md
+ *  @date 2021.
+ *
+ *  @file  Diagnostics.hpp
+ *  @brief Scoring kernels for the value-set diagnostic problems.
+ *
+ *  Each kernel reads a contiguous array of values and writes a same-sized array of scores,
+ *  returning the total score.  Rather than branching on each element, maxima are found with
+ *  order-free max reductions and sums use several independent accumulators (so both loops
+ *  vectorize); scores are then written with plain copies and fills.  Because the sums are split
+ *  across accumulators, totals can differ from a strict left-to-right sum in the last few bits.
+ *
+ *  ScoreDiagnosticBatch() runs a kernel over many value sets stored back to back in one
+ *  row-major matrix.
+ */
+
+#ifndef MABE_TOOL_DIAGNOSTICS_H
+#define MABE_TOOL_DIAGNOSTICS_H
+
+#include <algorithm>
+
+#include "emp/base/assert.hpp"
+
+namespace mabe {
+
+  /// Diagnostic problems for sets of values.
+  enum DiagnosticType {
+    DIAG_EXPLOIT=0,        // Must drive values as close to 100 as possible.
+    DIAG_STRUCT_EXPLOIT,   // Start at first value; only count values smaller than previous.
+    DIAG_EXPLORE,          // Start at max value; keep counting values if less than previous.
+    DIAG_DIVERSITY,        // ONLY count max value; all others are max - their current value.
+    DIAG_WEAK_DIVERSITY,   // ONLY count max value; all others don't count (and can drift)
+    NUM_DIAGNOSTICS
+  };
+
+  /// Sum values with four independent accumulators (so the loop can be vectorized).
+  inline double SumValues(const double * vals, size_t count) {
+    double sum0 = 0.0, sum1 = 0.0, sum2 = 0.0, sum3 = 0.0;
+    const size_t block_end = count - count % 4;
+    size_t i = 0;
+    for (; i < block_end; i += 4) {
+      sum0 += vals[i];
+      sum1 += vals[i+1];
+      sum2 += vals[i+2];
+      sum3 += vals[i+3];
+    }
+    for (; i < count; ++i) sum0 += vals[i];
+    return (sum0 + sum1) + (sum2 + sum3);
+  }
+
+  /// Find the position of the first maximum value (count must be at least one).
+  inline size_t FindFirstMax(const double * vals, size_t count) {
+    emp_assert(count > 0);
+    double max0 = vals[0], max1 = vals[0], max2 = vals[0], max3 = vals[0];
+    const size_t block_end = count - count % 4;
+    size_t i = 0;
+    for (; i < block_end; i += 4) {
+      max0 = std::max(max0, vals[i]);
+      max1 = std::max(max1, vals[i+1]);
+      max2 = std::max(max2, vals[i+2]);
+      max3 = std::max(max3, vals[i+3]);
+    }
+    for (; i < count; ++i) max0 = std::max(max0, vals[i]);
+    const double max_val = std::max(std::max(max0, max1), std::max(max2, max3));
+    return (size_t) (std::find(vals, vals + count, max_val) - vals);
+  }
+
+  /// Find the end of the non-increasing run of values that begins at start.
+  inline size_t FindRunEnd(const double * vals, size_t start, size_t count) {
+    size_t pos = start + 1;
+    while (pos < count && vals[pos] <= vals[pos-1]) ++pos;
+    return pos;
+  }
+
+  /// EXPLOIT: every value counts as is.
+  inline double ScoreExploit(const double * vals, double * scores, size_t count) {
+    std::copy(vals, vals + count, scores);
+    return SumValues(vals, count);
+  }
+
+  /// STRUCT_EXPLOIT: count values from the start for as long as they do not increase.
+  inline double ScoreStructExploit(const double * vals, double * scores, size_t count) {
+    if (count == 0) return 0.0;
+    const size_t end = FindRunEnd(vals, 0, count);
+    std::copy(vals, vals + end, scores);
+    std::fill(scores + end, scores + count, 0.0);
+    return SumValues(vals, end);
+  }
+
+  /// EXPLORE: count the max value and the values after it for as long as they do not increase.
+  inline double ScoreExplore(const double * vals, double * scores, size_t count) {
+    if (count == 0) return 0.0;
+    const size_t start = FindFirstMax(vals, count);
+    const size_t end = FindRunEnd(vals, start, count);
+    std::fill(scores, scores + start, 0.0);
+    std::copy(vals + start, vals + end, scores + start);
+    std::fill(scores + end, scores + count, 0.0);
+    return SumValues(vals + start, end - start);
+  }
+
+  /// DIVERSITY: count the max value; every other value scores half its distance below the max.
+  inline double ScoreDiversity(const double * vals, double * scores, size_t count) {
+    if (count == 0) return 0.0;
+    const size_t max_pos = FindFirstMax(vals, count);
+    const double max_val = vals[max_pos];
+    double sum0 = 0.0, sum1 = 0.0;
+    const size_t block_end = count - count % 2;
+    size_t i = 0;
+    for (; i < block_end; i += 2) {
+      sum0 += (scores[i] = (max_val - vals[i]) * 0.5);
+      sum1 += (scores[i+1] = (max_val - vals[i+1]) * 0.5);
+    }
+    for (; i < count; ++i) sum0 += (scores[i] = (max_val - vals[i]) * 0.5);
+    scores[max_pos] = max_val;    // The max itself had contributed zero above.
+    return max_val + (sum0 + sum1);
+  }
+
+  /// WEAK_DIVERSITY: count only the max value.
+  inline double ScoreWeakDiversity(const double * vals, double * scores, size_t count) {
+    if (count == 0) return 0.0;
+    const size_t max_pos = FindFirstMax(vals, count);
+    std::fill(scores, scores + count, 0.0);
+    scores[max_pos] = vals[max_pos];
+    return vals[max_pos];
+  }
+
+  /// Score a set of values on the given diagnostic; return the total score.
+  inline double ScoreDiagnostic(DiagnosticType type, const double * vals, double * scores,
+                                size_t count) {
+    switch (type) {
+    case DIAG_EXPLOIT:         return ScoreExploit(vals, scores, count);
+    case DIAG_STRUCT_EXPLOIT:  return ScoreStructExploit(vals, scores, count);
+    case DIAG_EXPLORE:         return ScoreExplore(vals, scores, count);
+    case DIAG_DIVERSITY:       return ScoreDiversity(vals, scores, count);
+    case DIAG_WEAK_DIVERSITY:  return ScoreWeakDiversity(vals, scores, count);
+    default:
+      emp_assert(false, "Unknown Diagnostic.", (int) type);
+    }
+    return 0.0;
+  }
+
+  /// Score num_sets value sets of set_size values each, stored back to back in vals; write
+  /// the matching scores (same layout) and one total per set.
+  inline void ScoreDiagnosticBatch(DiagnosticType type, const double * vals, double * scores,
+                                   double * totals, size_t num_sets, size_t set_size) {
+    for (size_t set_id = 0; set_id < num_sets; ++set_id) {
+      const size_t offset = set_id * set_size;
+      totals[set_id] = ScoreDiagnostic(type, vals + offset, scores + offset, set_size);
+    }
+  }
+
+}
+
+#endif
@@ -0,0 +1,151 @@
+/**
+ *  @note This file is part of MABE, https://github.com/mercere99/MABE2
+ *  @copyright Copyright (C) Michigan State University, MIT Software license; see doc/LICENSE.md
+ *  @date 2021.
+ *
+ *  @file  InlineVector.hpp
+ *  @brief A fixed-capacity vector whose contents are stored inline (no heap allocation).
+ *
+ *  Vector-valued traits (such as per-test-case scores) are normally stored in a DataMap as an
+ *  emp::vector, which requires a separate heap allocation for every organism and a deep copy
+ *  every time an organism is cloned.  An InlineVector keeps its values directly inside the
+ *  object, so it is trivially copyable; when used as a trait the values live inside the
+ *  DataMap's own memory block and an organism clone is a single contiguous copy.
+ *
+ *  The capacity is part of the type, so any InlineVector<T, CAPACITY> can be stored as a trait.
+ *  However, TraitSet (and so lexicase selection) only reads InlineTraitVector<T>, which always
+ *  has the standard capacity of INLINE_TRAIT_CAPACITY values; traits meant for those consumers
+ *  must use that type, and cannot hold more values than that.
+ *
+ *  Any attempt to grow past the capacity raises an error (in all build modes) and the extra
+ *  values are dropped.
+ */
+
+#ifndef MABE_INLINE_VECTOR_H
+#define MABE_INLINE_VECTOR_H
+
+#include <algorithm>
+#include <initializer_list>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+#include "emp/base/assert.hpp"
+#include "emp/base/notify.hpp"
+#include "emp/base/vector.hpp"
+
+namespace mabe {
+
+  template <typename T, size_t CAPACITY>
+  class InlineVector {
+  private:
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "InlineVector can only hold trivially copyable types.");
+    static_assert(CAPACITY > 0, "InlineVector must have a non-zero capacity.");
+
+    size_t num_vals = 0;     ///< How many positions are currently in use?
+    T vals[CAPACITY] = {};   ///< Inline storage for all values.
+
+    /// Limit a requested size to the capacity, raising an error if it does not fit.
+    static size_t ClampSize(size_t in_size) {
+      if (in_size <= CAPACITY) return in_size;
+      emp::notify::Error("InlineVector needs ", in_size, " values, but capacity is only ",
+                         CAPACITY, "; extra values dropped.");
+      return CAPACITY;
+    }
+
+  public:
+    using value_type = T;
+    using iterator = T *;
+    using const_iterator = const T *;
+
+    InlineVector() = default;
+    InlineVector(size_t in_size, const T & value = T()) { resize(in_size, value); }
+    InlineVector(std::initializer_list<T> in_vals) { Assign(in_vals.begin(), in_vals.size()); }
+    InlineVector(const emp::vector<T> & in_vals) { Assign(in_vals); }
+    InlineVector(const InlineVector &) = default;
+    InlineVector & operator=(const InlineVector &) = default;
+
+    static constexpr size_t Capacity() { return CAPACITY; }
+    static constexpr size_t capacity() { return CAPACITY; }
+
+    size_t size() const { return num_vals; }
+    bool empty() const { return num_vals == 0; }
+    bool IsFull() const { return num_vals == CAPACITY; }
+
+    /// Change the number of values in use; new positions are set to value.
+    void resize(size_t new_size, const T & value = T()) {
+      new_size = ClampSize(new_size);
+      for (size_t i = num_vals; i < new_size; ++i) vals[i] = value;
+      num_vals = new_size;
+    }
+    void clear() { num_vals = 0; }
+
+    void push_back(const T & value) {
+      if (ClampSize(num_vals + 1) > num_vals) vals[num_vals++] = value;
+    }
+    void pop_back() {
+      emp_assert(num_vals > 0, "pop_back() called on empty InlineVector.");
+      --num_vals;
+    }
+
+    /// Replace the current contents with count values starting at in_vals.
+    void Assign(const T * in_vals, size_t count) {
+      num_vals = ClampSize(count);
+      std::copy(in_vals, in_vals + num_vals, vals);
+    }
+
+    /// Replace the current contents with values from a standard vector.
+    void Assign(const emp::vector<T> & in_vals) { Assign(in_vals.data(), in_vals.size()); }
+
+    T & operator[](size_t pos) { emp_assert(pos < num_vals, pos, num_vals); return vals[pos]; }
+    const T & operator[](size_t pos) const { emp_assert(pos < num_vals, pos, num_vals); return vals[pos]; }
+
+    T & front() { emp_assert(num_vals > 0); return vals[0]; }
+    const T & front() const { emp_assert(num_vals > 0); return vals[0]; }
+    T & back() { emp_assert(num_vals > 0); return vals[num_vals-1]; }
+    const T & back() const { emp_assert(num_vals > 0); return vals[num_vals-1]; }
+
+    T * data() { return vals; }
+    const T * data() const { return vals; }
+
+    iterator begin() { return vals; }
+    iterator end() { return vals + num_vals; }
+    const_iterator begin() const { return vals; }
+    const_iterator end() const { return vals + num_vals; }
+
+    /// Convert to a standard vector (e.g., for modules that require one).
+    emp::vector<T> AsVector() const { return emp::vector<T>(begin(), end()); }
+
+    bool operator==(const InlineVector & in) const {
+      return num_vals == in.num_vals && std::equal(begin(), end(), in.begin());
+    }
+    bool operator!=(const InlineVector & in) const { return !(*this == in); }
+
+    std::string ToString() const {
+      std::stringstream ss;
+      ss << *this;
+      return ss.str();
+    }
+
+    friend std::ostream & operator<<(std::ostream & os, const InlineVector & v) {
+      os << "[";
+      for (size_t i = 0; i < v.num_vals; ++i) {
+        if (i) os << ",";
+        os << v.vals[i];
+      }
+      os << "]";
+      return os;
+    }
+  };
+
+  /// Capacity of InlineTraitVector, the only inline vector type that TraitSet can read.
+  constexpr size_t INLINE_TRAIT_CAPACITY = 128;
+
+  template <typename T>
+  using InlineTraitVector = InlineVector<T, INLINE_TRAIT_CAPACITY>;
+
+}
+
+#endif
@@ -0,0 +1,131 @@
+/**
+ *  @note This file is part of MABE, https://github.com/mercere99/MABE2
+ *  @copyright Copyright (C) Michigan State University, MIT Software license; see doc/LICENSE.md
+ *  @date 2021.
+ *
+ *  @file  LRUCache.hpp
+ *  @brief A fixed-capacity key/value cache that evicts the least recently used entry.
+ *
+ *  Entries live in a single array allocated up front and are linked (by index) into a list
+ *  ordered from most to least recently used; a hash map finds entries by key.  Once full,
+ *  each new entry reuses the slot of the least recently used one, so memory stays bounded.
+ *  Hits and misses are counted so that callers can report hit rates.
+ *
+ *  The cache is not thread-safe (even lookups reorder entries); callers running in parallel
+ *  should look up and store results from a single thread.
+ */
+
+#ifndef MABE_TOOL_LRU_CACHE_H
+#define MABE_TOOL_LRU_CACHE_H
+
+#include <functional>
+#include <unordered_map>
+
+#include "emp/base/assert.hpp"
+#include "emp/base/vector.hpp"
+
+namespace mabe {
+
+  template <typename KEY_T, typename VALUE_T, typename HASH_T=std::hash<KEY_T>>
+  class LRUCache {
+  private:
+    static constexpr size_t NO_ENTRY = (size_t) -1;
+
+    struct Entry {
+      KEY_T key;
+      VALUE_T value;
+      size_t prev = NO_ENTRY;   ///< More recently used entry.
+      size_t next = NO_ENTRY;   ///< Less recently used entry.
+    };
+
+    emp::vector<Entry> entries;                       ///< All entries in use.
+    std::unordered_map<KEY_T, size_t, HASH_T> index;  ///< Position of each key in entries.
+    size_t capacity = 0;         ///< Maximum number of entries to keep.
+    size_t head = NO_ENTRY;      ///< Most recently used entry.
+    size_t tail = NO_ENTRY;      ///< Least recently used entry.
+    size_t num_hits = 0;
+    size_t num_misses = 0;
+
+    void Unlink(size_t id) {
+      Entry & entry = entries[id];
+      if (entry.prev != NO_ENTRY) entries[entry.prev].next = entry.next;
+      else head = entry.next;
+      if (entry.next != NO_ENTRY) entries[entry.next].prev = entry.prev;
+      else tail = entry.prev;
+    }
+
+    void LinkFront(size_t id) {
+      Entry & entry = entries[id];
+      entry.prev = NO_ENTRY;
+      entry.next = head;
+      if (head != NO_ENTRY) entries[head].prev = id;
+      head = id;
+      if (tail == NO_ENTRY) tail = id;
+    }
+
+  public:
+    LRUCache(size_t _capacity=0) { SetCapacity(_capacity); }
+
+    /// Set the maximum number of entries (clearing the cache).
+    void SetCapacity(size_t _capacity) {
+      capacity = _capacity;
+      Clear();
+      entries.reserve(capacity);
+      index.reserve(capacity);
+    }
+
+    /// Remove all entries (statistics are kept).
+    void Clear() {
+      entries.resize(0);
+      index.clear();
+      head = tail = NO_ENTRY;
+    }
+
+    size_t GetCapacity() const { return capacity; }
+    size_t GetSize() const { return entries.size(); }
+    size_t GetHits() const { return num_hits; }
+    size_t GetMisses() const { return num_misses; }
+    void ResetStats() { num_hits = num_misses = 0; }
+
+    /// Look up a key; if found, copy its value into out, mark it as most recently used, and
+    /// return true.
+    bool Get(const KEY_T & key, VALUE_T & out) {
+      auto it = index.find(key);
+      if (it == index.end()) { ++num_misses; return false; }
+      ++num_hits;
+      const size_t id = it->second;
+      if (id != head) { Unlink(id); LinkFront(id); }
+      out = entries[id].value;
+      return true;
+    }
+
+    /// Store a value for a key as the most recently used entry, evicting the least recently
+    /// used entry if the cache is full.
+    void Put(const KEY_T & key, const VALUE_T & value) {
+      if (capacity == 0) return;
+      auto it = index.find(key);
+      size_t id;
+      if (it != index.end()) {           // Already present; update it.
+        id = it->second;
+        Unlink(id);
+      }
+      else if (entries.size() < capacity) {
+        id = entries.size();
+        entries.push_back(Entry{key, value});
+        index[key] = id;
+      }
+      else {                             // Full; reuse the least recently used slot.
+        id = tail;
+        Unlink(id);
+        index.erase(entries[id].key);
+        entries[id].key = key;
+        index[key] = id;
+      }
+      entries[id].value = value;
+      LinkFront(id);
+    }
+  };
+
+}
+
+#endif
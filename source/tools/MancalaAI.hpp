@@ -0,0 +1,292 @@
+/**
+ *  @note This file is part of MABE, https://github.com/mercere99/MABE2
+ *  @copyright Copyright (C) Michigan State University, MIT Software license; see doc/LICENSE.md
+ *  @date 2021.
+ *
+ *  @file  MancalaAI.hpp
+ *  @brief A depth-limited alpha-beta search player for MancalaBoard.
+ *
+ *  Positions are scored as the difference between the two stores from the point of view of
+ *  the player to move.  The search is negamax with alpha-beta pruning; since a move ending in
+ *  one's own store earns another turn, a child position is only negated when the player to
+ *  move actually changes.  Each move is chosen by iterative deepening (depth 1, 2, ... up to
+ *  the configured depth), and moves are tried best-first: the best move found by a shallower
+ *  search, then moves that earn an extra turn, then the rest.
+ *
+ *  Searched positions are stored in a transposition table indexed by a Zobrist hash of the
+ *  board.  The table is lockless (each entry is two atomic words, with the key stored XORed
+ *  with the data so torn writes are detected), so one table can be shared by many threads
+ *  playing different games at once.  Stored values are only reused for a search of exactly
+ *  the same depth, and ties at the root always go to the lowest pit, so the chosen move
+ *  depends only on the board and the depth -- never on what is in the table or on thread
+ *  timing.  Chosen moves are stored too, so a position seen again (as is common when many
+ *  similar organisms face the AI) is answered with a single lookup.  The work per move is
+ *  bounded by the depth: on the order of 6^depth positions at worst, and far fewer in
+ *  practice with good move ordering.
+ */
+
+#ifndef MABE_TOOL_MANCALA_AI_H
+#define MABE_TOOL_MANCALA_AI_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "emp/base/assert.hpp"
+#include "emp/base/vector.hpp"
+
+#include "MancalaBoard.hpp"
+#include "StreamHash.hpp"
+
+namespace mabe {
+
+  class MancalaAI {
+  public:
+    static constexpr size_t MAX_DEPTH = 24;   ///< Deepest search allowed.
+
+  private:
+    static constexpr size_t MAX_STONES = MancalaBoard::NUM_PITS * 2 * MancalaBoard::START_STONES;
+    static constexpr int INF_SCORE = 1000;    ///< Larger than any possible score difference.
+
+    // Bound types for stored values.
+    static constexpr uint64_t BOUND_EXACT = 0;
+    static constexpr uint64_t BOUND_LOWER = 1;  // True value is at least the stored value.
+    static constexpr uint64_t BOUND_UPPER = 2;  // True value is at most the stored value.
+    static constexpr uint64_t ROOT_CHOICE = 1ull << 26;  // Move is the one PickMove() chose.
+    static constexpr uint64_t ENTRY_VALID = 1ull << 63;
+
+    /// Fixed random keys for each (cell, stone count), and for player 1 being the one to move.
+    struct ZobristKeys {
+      std::array<std::array<uint64_t, MAX_STONES + 1>, MancalaBoard::NUM_CELLS> cells;
+      uint64_t player1;
+    };
+
+    /// Counts kept locally during one move choice and added to the totals afterwards.
+    struct SearchStats {
+      size_t positions = 0;
+      size_t table_hits = 0;
+    };
+
+    size_t depth = 6;                          ///< How many moves ahead to search.
+    size_t table_mask = 0;                     ///< Number of table entries minus one.
+    emp::vector<std::atomic<uint64_t>> table;  ///< Two words per entry: key^data, then data.
+    std::atomic<size_t> total_positions{0};    ///< Positions searched since the last Clear().
+    std::atomic<size_t> total_table_hits{0};   ///< ...and how many were resolved by the table.
+    std::atomic<size_t> total_moves{0};        ///< Moves chosen since the last Clear().
+    std::atomic<size_t> total_moves_reused{0}; ///< ...and how many were found without searching.
+
+    static const ZobristKeys & GetZobristKeys() {
+      static const ZobristKeys keys = [](){
+        ZobristKeys out;
+        uint64_t seed = 0;
+        auto next_key = [&seed](){                        // SplitMix64 sequence.
+          return MixBits(seed += 0x9e3779b97f4a7c15ULL);
+        };
+        for (auto & cell_keys : out.cells) {
+          for (uint64_t & key : cell_keys) key = next_key();
+        }
+        out.player1 = next_key();
+        return out;
+      }();
+      return keys;
+    }
+
+    static uint64_t HashBoard(const MancalaBoard & board) {
+      const ZobristKeys & keys = GetZobristKeys();
+      const auto & cells = board.GetCells();
+      uint64_t hash = board.GetCurPlayer() ? keys.player1 : 0;
+      for (size_t i = 0; i < MancalaBoard::NUM_CELLS; ++i) hash ^= keys.cells[i][cells[i]];
+      return hash;
+    }
+
+    /// Score a position from the point of view of the player to move.
+    static int ScoreBoard(const MancalaBoard & board) {
+      const size_t player = board.GetCurPlayer();
+      return (int) board.GetStore(player) - (int) board.GetStore(1 - player);
+    }
+
+    static uint64_t PackEntry(int value, size_t entry_depth, uint64_t bound, size_t move) {
+      return ENTRY_VALID | (uint64_t) (uint16_t) (int16_t) value | ((uint64_t) entry_depth << 16)
+             | (bound << 24) | ((uint64_t) move << 32);
+    }
+    static int EntryValue(uint64_t data) { return (int16_t) (uint16_t) (data & 0xFFFF); }
+    static size_t EntryDepth(uint64_t data) { return (data >> 16) & 0xFF; }
+    static uint64_t EntryBound(uint64_t data) { return (data >> 24) & 0x3; }
+    static size_t EntryMove(uint64_t data) { return (data >> 32) & 0xFF; }
+    static bool IsRootChoice(uint64_t data) { return data & ROOT_CHOICE; }
+
+    /// Find the stored data for a board key, or return 0 if there is none.
+    uint64_t Probe(uint64_t key) const {
+      const size_t pos = (key & table_mask) * 2;
+      const uint64_t data = table[pos+1].load(std::memory_order_relaxed);
+      const uint64_t check = table[pos].load(std::memory_order_relaxed);
+      return ((check ^ data) == key) ? data : 0;
+    }
+
+    void Store(uint64_t key, uint64_t data) {
+      const size_t pos = (key & table_mask) * 2;
+      table[pos].store(key ^ data, std::memory_order_relaxed);
+      table[pos+1].store(data, std::memory_order_relaxed);
+    }
+
+    /// Fill moves with the legal moves in the order to try them; return how many there are.
+    static size_t OrderMoves(const MancalaBoard & board, size_t first_move,
+                             std::array<uint8_t, MancalaBoard::NUM_PITS> & moves) {
+      const size_t player = board.GetCurPlayer();
+      uint32_t mask = board.GetMoveMask();
+      size_t count = 0;
+      if (first_move < MancalaBoard::NUM_PITS && (mask & (1u << first_move))) {
+        moves[count++] = (uint8_t) first_move;
+        mask &= ~(1u << first_move);
+      }
+      // Moves that end in our own store (a whole number of laps plus the distance to it) earn
+      // another turn; try those next, starting from the pit closest to the store.
+      for (size_t pit = MancalaBoard::NUM_PITS; pit-- > 0;) {
+        const size_t to_store = MancalaBoard::NUM_PITS - pit;
+        if ((mask & (1u << pit)) && board.GetPit(player, pit) % 13 == to_store) {
+          moves[count++] = (uint8_t) pit;
+          mask &= ~(1u << pit);
+        }
+      }
+      for (size_t pit = MancalaBoard::NUM_PITS; pit-- > 0;) {
+        if (mask & (1u << pit)) moves[count++] = (uint8_t) pit;
+      }
+      return count;
+    }
+
+    /// Value of a move for the player who made it, given the board after the move.
+    int SearchChild(const MancalaBoard & next, size_t player, size_t child_depth,
+                    int alpha, int beta, SearchStats & stats) {
+      if (next.GetCurPlayer() == player) return Search(next, child_depth, alpha, beta, stats);
+      return -Search(next, child_depth, -beta, -alpha, stats);
+    }
+
+    /// Negamax search with alpha-beta pruning; returns the board's value for the player to
+    /// move (exact if strictly between alpha and beta, otherwise a bound on that side).
+    int Search(const MancalaBoard & board, size_t cur_depth, int alpha, int beta,
+               SearchStats & stats) {
+      ++stats.positions;
+      if (cur_depth == 0 || board.IsDone()) return ScoreBoard(board);
+
+      const uint64_t key = HashBoard(board);
+      size_t first_move = MancalaBoard::NUM_PITS;
+      if (const uint64_t data = Probe(key)) {
+        first_move = EntryMove(data);
+        if (EntryDepth(data) == cur_depth) {
+          const int value = EntryValue(data);
+          const uint64_t bound = EntryBound(data);
+          if (bound == BOUND_EXACT || (bound == BOUND_LOWER && value >= beta)
+              || (bound == BOUND_UPPER && value <= alpha)) {
+            ++stats.table_hits;
+            return value;
+          }
+        }
+      }
+
+      const size_t player = board.GetCurPlayer();
+      const int start_alpha = alpha;
+      std::array<uint8_t, MancalaBoard::NUM_PITS> moves;
+      const size_t num_moves = OrderMoves(board, first_move, moves);
+      int best_value = -INF_SCORE;
+      size_t best_move = moves[0];
+      for (size_t i = 0; i < num_moves; ++i) {
+        MancalaBoard next(board);
+        next.DoMove(moves[i]);
+        const int value = SearchChild(next, player, cur_depth - 1, alpha, beta, stats);
+        if (value > best_value) { best_value = value; best_move = moves[i]; }
+        if (value > alpha) alpha = value;
+        if (alpha >= beta) break;
+      }
+
+      const uint64_t bound = (best_value <= start_alpha) ? BOUND_UPPER
+                           : (best_value >= beta) ? BOUND_LOWER : BOUND_EXACT;
+      Store(key, PackEntry(best_value, cur_depth, bound, best_move));
+      return best_value;
+    }
+
+    /// Find the best move at a given depth, trying prev_best first.  Each move must beat the
+    /// best so far (or tie it from a lower pit), so the lowest of the best pits is returned
+    /// no matter what order moves were tried in.  The (exact) value and choice are stored.
+    size_t SearchRoot(const MancalaBoard & board, uint64_t key, size_t cur_depth,
+                      size_t prev_best, SearchStats & stats) {
+      ++stats.positions;
+      const size_t player = board.GetCurPlayer();
+      std::array<uint8_t, MancalaBoard::NUM_PITS> moves;
+      const size_t num_moves = OrderMoves(board, prev_best, moves);
+      int best_value = -INF_SCORE;
+      size_t best_move = MancalaBoard::NUM_PITS;
+      for (size_t i = 0; i < num_moves; ++i) {
+        const size_t move = moves[i];
+        const int to_beat = (best_move < move) ? best_value : (best_value - 1);
+        MancalaBoard next(board);
+        next.DoMove(move);
+        const int value = SearchChild(next, player, cur_depth - 1, to_beat, INF_SCORE, stats);
+        if (value > to_beat) { best_value = value; best_move = move; }
+      }
+      Store(key, PackEntry(best_value, cur_depth, BOUND_EXACT, best_move) | ROOT_CHOICE);
+      return best_move;
+    }
+
+  public:
+    MancalaAI(size_t _depth=6, size_t table_bits=20) { Setup(_depth, table_bits); }
+    MancalaAI(const MancalaAI &) = delete;
+    MancalaAI & operator=(const MancalaAI &) = delete;
+
+    size_t GetDepth() const { return depth; }
+    size_t GetTableSize() const { return table_mask + 1; }
+    size_t GetPositions() const { return total_positions; }
+    size_t GetTableHits() const { return total_table_hits; }
+    size_t GetMoves() const { return total_moves; }
+    size_t GetMovesReused() const { return total_moves_reused; }
+
+    /// Set the search depth and the transposition table size (2^table_bits entries, sixteen
+    /// bytes each); the table is emptied either way.  Not safe while moves are being chosen.
+    void Setup(size_t _depth, size_t table_bits) {
+      emp_assert(_depth >= 1 && _depth <= MAX_DEPTH, _depth);
+      emp_assert(table_bits < 40, table_bits);
+      depth = _depth;
+      const size_t table_size = (size_t) 1 << table_bits;
+      if (table_size != GetTableSize() || table.size() == 0) {
+        table_mask = table_size - 1;
+        table = emp::vector<std::atomic<uint64_t>>(table_size * 2);
+      }
+      Clear();
+    }
+
+    /// Empty the transposition table and reset the counts.  Not safe while moves are being
+    /// chosen.
+    void Clear() {
+      for (std::atomic<uint64_t> & word : table) word.store(0, std::memory_order_relaxed);
+      total_positions = 0;
+      total_table_hits = 0;
+      total_moves = 0;
+      total_moves_reused = 0;
+    }
+
+    /// Choose a move for the current player.  Safe to call from many threads at once.
+    size_t PickMove(const MancalaBoard & board) {
+      emp_assert(!board.IsDone(), "No legal moves.");
+      total_moves.fetch_add(1, std::memory_order_relaxed);
+      const uint64_t key = HashBoard(board);
+      const uint64_t data = Probe(key);
+      if (data && IsRootChoice(data) && EntryDepth(data) == depth) {
+        total_moves_reused.fetch_add(1, std::memory_order_relaxed);
+        return EntryMove(data);
+      }
+
+      SearchStats stats;
+      size_t best_move = MancalaBoard::NUM_PITS;
+      for (size_t cur_depth = 1; cur_depth <= depth; ++cur_depth) {
+        best_move = SearchRoot(board, key, cur_depth, best_move, stats);
+      }
+      total_positions.fetch_add(stats.positions, std::memory_order_relaxed);
+      total_table_hits.fetch_add(stats.table_hits, std::memory_order_relaxed);
+      return best_move;
+    }
+
+    size_t operator()(const MancalaBoard & board) { return PickMove(board); }
+  };
+
+}
+
+#endif
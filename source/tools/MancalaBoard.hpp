@@ -0,0 +1,219 @@
+/**
+ *  @note This file is part of MABE, https://github.com/mercere99/MABE2
+ *  @copyright Copyright (C) Michigan State University, MIT Software license; see doc/LICENSE.md
+ *  @date 2021.
+ *
+ *  @file  MancalaBoard.hpp
+ *  @brief A compact, fixed-size Mancala (Kalah) board with an allocation-free game loop.
+ *
+ *  The whole game state fits in 16 bytes: fourteen one-byte pits plus the player to move and
+ *  whether the game is over.  Pits 0-5 belong to player 0 (with pit 6 as their store) and pits
+ *  7-12 belong to player 1 (with pit 13 as their store).  Moves are numbered 0-5 from the
+ *  point of view of the player making them, and the legal moves are available as a six-bit
+ *  mask, so boards can be copied and searched freely without touching the heap.
+ *
+ *  Rules (Kalah, four stones per pit): a move sows every stone from one of the mover's pits
+ *  counter-clockwise, skipping the opponent's store.  Ending in one's own store earns another
+ *  turn; ending in an empty pit on one's own side captures that stone and any stones in the
+ *  opposite pit (if there are any).  When either side runs out of stones the game ends and
+ *  each player banks the stones remaining on their own side.
+ *
+ *  Players are passed to PlayMancala() as any callable object taking the board and returning a
+ *  move, so calls can be inlined rather than going through std::function.
+ */
+
+#ifndef MABE_TOOL_MANCALA_BOARD_H
+#define MABE_TOOL_MANCALA_BOARD_H
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+
+#include "emp/base/assert.hpp"
+#include "emp/base/vector.hpp"
+#include "emp/math/Random.hpp"
+
+namespace mabe {
+
+  class MancalaBoard {
+  public:
+    static constexpr size_t NUM_PITS = 6;     ///< Playable pits on each side.
+    static constexpr size_t NUM_CELLS = 14;   ///< Pits plus stores for both players.
+    static constexpr size_t START_STONES = 4; ///< Stones in each pit at the start.
+
+  private:
+    std::array<uint8_t, NUM_CELLS> cells;     ///< Stones in each pit and store.
+    uint8_t cur_player = 0;                   ///< Whose turn is it? (0 or 1)
+    bool over = false;                        ///< Has the game ended?
+
+    static constexpr size_t StoreID(size_t player) { return player * 7 + 6; }
+    static constexpr size_t PitID(size_t player, size_t pit) { return player * 7 + pit; }
+
+    /// Check if either side is empty; if so, bank all remaining stones and end the game.
+    void TestOver() {
+      bool empty0 = true, empty1 = true;
+      for (size_t i = 0; i < NUM_PITS; ++i) {
+        empty0 &= (cells[i] == 0);
+        empty1 &= (cells[7+i] == 0);
+      }
+      if (!empty0 && !empty1) return;
+      for (size_t i = 0; i < NUM_PITS; ++i) {
+        cells[6] += cells[i];     cells[i] = 0;
+        cells[13] += cells[7+i];  cells[7+i] = 0;
+      }
+      over = true;
+    }
+
+  public:
+    MancalaBoard(size_t first_player=0) { Reset(first_player); }
+    MancalaBoard(const MancalaBoard &) = default;
+    MancalaBoard & operator=(const MancalaBoard &) = default;
+
+    /// Set up the board for a new game.
+    void Reset(size_t first_player=0) {
+      emp_assert(first_player < 2, first_player);
+      cells.fill((uint8_t) START_STONES);
+      cells[StoreID(0)] = cells[StoreID(1)] = 0;
+      cur_player = (uint8_t) first_player;
+      over = false;
+    }
+
+    size_t GetCurPlayer() const { return cur_player; }
+    bool IsDone() const { return over; }
+
+    /// Stones in a pit (0-5) for a given player, or in their store (pit 6).
+    size_t GetPit(size_t player, size_t pit) const { return cells[PitID(player, pit)]; }
+    size_t GetStore(size_t player) const { return cells[StoreID(player)]; }
+    size_t GetScore(size_t player) const { return GetStore(player); }
+    size_t ScoreA() const { return GetStore(0); }
+    size_t ScoreB() const { return GetStore(1); }
+    const std::array<uint8_t, NUM_CELLS> & GetCells() const { return cells; }
+
+    /// Bit mask of legal moves for the current player (bit i set if pit i is non-empty).
+    uint32_t GetMoveMask() const {
+      const size_t base = PitID(cur_player, 0);
+      uint32_t mask = 0;
+      for (size_t i = 0; i < NUM_PITS; ++i) mask |= (uint32_t) (cells[base+i] != 0) << i;
+      return over ? 0 : mask;
+    }
+
+    bool IsMoveValid(size_t move) const {
+      return move < NUM_PITS && !over && cells[PitID(cur_player, move)] != 0;
+    }
+
+    /// Perform a move for the current player; return true if they get to go again.
+    bool DoMove(size_t move) {
+      emp_assert(IsMoveValid(move), move);
+      const size_t player = cur_player;
+      const size_t skip = StoreID(1 - player);     // Never sow into opponent's store.
+      size_t pos = PitID(player, move);
+      size_t stones = cells[pos];
+      cells[pos] = 0;
+
+      // Whole laps around the board add one stone to each of the 13 cells we can sow into.
+      if (stones >= NUM_CELLS - 1) {
+        const size_t laps = stones / (NUM_CELLS - 1);
+        for (size_t i = 0; i < NUM_CELLS; ++i) if (i != skip) cells[i] += (uint8_t) laps;
+        stones -= laps * (NUM_CELLS - 1);   // If none remain, the last stone landed back in pos.
+      }
+      while (stones > 0) {
+        if (++pos == NUM_CELLS) pos = 0;
+        if (pos == skip) continue;
+        ++cells[pos];
+        --stones;
+      }
+
+      // Landing in our own store earns another turn.
+      if (pos == StoreID(player)) {
+        TestOver();
+        return !over;
+      }
+
+      // Landing in an empty pit on our own side captures the opposite pit.
+      const size_t opposite = 12 - pos;
+      if (pos / 7 == player && cells[pos] == 1 && cells[opposite] > 0) {
+        cells[StoreID(player)] += cells[opposite] + 1;
+        cells[opposite] = 0;
+        cells[pos] = 0;
+      }
+
+      TestOver();
+      cur_player ^= 1;
+      return false;
+    }
+
+    /// Write the board as seen by a player: their pits and store, then the opponent's pits and
+    /// store.  The vector is only resized if needed, so it can be reused across moves.
+    void FillInputs(size_t player, emp::vector<double> & inputs) const {
+      inputs.resize(NUM_CELLS);
+      const size_t offset = player * 7;
+      for (size_t i = 0; i < NUM_CELLS; ++i) {
+        const size_t cell = (i + offset < NUM_CELLS) ? (i + offset) : (i + offset - NUM_CELLS);
+        inputs[i] = cells[cell];
+      }
+    }
+
+    /// Print the board with player 1 on top (right to left) and player 0 below.
+    void Print(std::ostream & os=std::cout) const {
+      os << "  ";
+      for (size_t i = NUM_PITS; i > 0; --i) os << " " << (int) cells[PitID(1, i-1)];
+      os << "\n " << (int) cells[StoreID(1)] << "               " << (int) cells[StoreID(0)];
+      os << "\n  ";
+      for (size_t i = 0; i < NUM_PITS; ++i) os << " " << (int) cells[PitID(0, i)];
+      os << "\n   A B C D E F   (player " << (int) cur_player << " to move)" << std::endl;
+    }
+  };
+
+  /// Choose uniformly among the legal moves for the current player.
+  inline size_t PickRandomMancalaMove(const MancalaBoard & board, emp::Random & random) {
+    uint32_t mask = board.GetMoveMask();
+    emp_assert(mask != 0, "No legal moves.");
+    size_t skip = random.GetUInt(__builtin_popcount(mask));
+    while (skip--) mask &= mask - 1;     // Clear the lowest legal moves we are skipping.
+    return (size_t) __builtin_ctz(mask);
+  }
+
+  /// A simple one-move lookahead: choose the legal move that banks the most stones right away
+  /// (counting an extra turn as one more stone); ties go to the lowest pit.
+  inline size_t PickGreedyMancalaMove(const MancalaBoard & board) {
+    const size_t player = board.GetCurPlayer();
+    const size_t start_score = board.GetStore(player);
+    size_t best_move = 0;
+    size_t best_gain = 0;
+    bool found = false;
+    for (size_t move = 0; move < MancalaBoard::NUM_PITS; ++move) {
+      if (!board.IsMoveValid(move)) continue;
+      MancalaBoard next(board);
+      const bool go_again = next.DoMove(move);
+      const size_t gain = next.GetStore(player) - start_score + (go_again ? 1 : 0);
+      if (!found || gain > best_gain) {
+        best_move = move;
+        best_gain = gain;
+        found = true;
+      }
+    }
+    return best_move;
+  }
+
+  /// Play out a game from the given board; player0 and player1 are called with the board and
+  /// return their chosen move.  Illegal choices are shifted to the next legal pit, and
+  /// on_illegal(player) is called for each pit skipped.  Returns the finished board.
+  template <typename P0_T, typename P1_T, typename ILLEGAL_T>
+  MancalaBoard PlayMancala(MancalaBoard board, P0_T && player0, P1_T && player1,
+                           ILLEGAL_T && on_illegal) {
+    while (!board.IsDone()) {
+      const size_t player = board.GetCurPlayer();
+      size_t move = (player == 0) ? player0(board) : player1(board);
+      if (move >= MancalaBoard::NUM_PITS) move %= MancalaBoard::NUM_PITS;
+      while (!board.IsMoveValid(move)) {
+        on_illegal(player);
+        if (++move == MancalaBoard::NUM_PITS) move = 0;
+      }
+      board.DoMove(move);
+    }
+    return board;
+  }
+
+}
+
+#endif
@@ -0,0 +1,203 @@
+/**
+ *  @note This file is part of MABE, https://github.com/mercere99/MABE2
+ *  @copyright Copyright (C) Michigan State University, MIT Software license; see doc/LICENSE.md
+ *  @date 2021.
+ *
+ *  @file  MatchScheduler.hpp
+ *  @brief Tools to schedule player-vs-player matches in rounds and run each round in parallel.
+ *
+ *  A tournament is played as a series of rounds.  In each round, every player appears in at
+ *  most one match (with one player sitting out if the count is odd), so all of the matches
+ *  in a round touch disjoint players and can safely run at the same time.  Three pairings
+ *  are provided:
+ *
+ *    Round robin : The circle method; num_players-1 rounds (rounded up to even) where every
+ *                  player meets every other player exactly once.
+ *    Random      : Each round is a fresh random pairing, so K rounds gives K random opponents.
+ *    Swiss       : Players are ranked by their current scores and each is paired with the next
+ *                  player in the ranking that they have not already met; the first round (when
+ *                  all scores are equal) is random.
+ *
+ *  A MatchHistory records who has met whom and how many rounds each player has sat out.  With
+ *  an odd number of players, random and Swiss rounds give the bye to a player who has sat out
+ *  the fewest rounds so far, so byes rotate; even so, K rounds only guarantees each player
+ *  K-1 to K matches (a round robin with an odd count also gives each player one bye).
+ *
+ *  RunParallel() runs a set of independent jobs on a number of threads.  Jobs should write
+ *  only to their own result slots; combining those results in job order afterwards keeps the
+ *  outcome independent of how many threads were used.
+ */
+
+#ifndef MABE_TOOL_MATCH_SCHEDULER_H
+#define MABE_TOOL_MATCH_SCHEDULER_H
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <thread>
+#include <unordered_set>
+
+#include "emp/base/assert.hpp"
+#include "emp/base/vector.hpp"
+#include "emp/math/Random.hpp"
+
+namespace mabe {
+
+  /// A single match between two players (identified by their index).
+  struct MatchPair {
+    size_t player0;
+    size_t player1;
+  };
+
+  /// How many rounds does a round robin need for num_players?
+  inline size_t CountRoundRobinRounds(size_t num_players) {
+    if (num_players < 2) return 0;
+    return (num_players % 2) ? num_players : (num_players - 1);
+  }
+
+  /// Fill pairs with the matches for one round of a round robin (circle method): player 0
+  /// stays fixed while the others rotate.  With an odd number of players, whoever would face
+  /// the extra (phantom) player sits out.
+  inline void BuildRoundRobinRound(size_t num_players, size_t round, emp::vector<MatchPair> & pairs) {
+    pairs.resize(0);
+    if (num_players < 2) return;
+    const size_t size = num_players + (num_players % 2);   // Even count, including phantom.
+    const size_t cycle = size - 1;
+    emp_assert(round < cycle, round, cycle);
+
+    // Position 0 is fixed; positions 1 to size-1 hold players rotated by round.
+    auto PlayerAt = [cycle, round](size_t pos) {
+      return (pos == 0) ? 0 : (1 + (pos - 1 + round) % cycle);
+    };
+    for (size_t i = 0; i < size / 2; ++i) {
+      size_t player0 = PlayerAt(i);
+      size_t player1 = PlayerAt(size - 1 - i);
+      if (player0 >= num_players || player1 >= num_players) continue;  // Phantom; sit out.
+      if ((round + i) % 2) std::swap(player0, player1);                // Alternate sides.
+      pairs.push_back(MatchPair{player0, player1});
+    }
+  }
+
+  /// Which players have met, and how many rounds has each player sat out?
+  class MatchHistory {
+  private:
+    size_t num_players = 0;
+    emp::vector<size_t> byes;           ///< Rounds each player has sat out.
+    std::unordered_set<size_t> met;     ///< Pairs that have played (as lower*num_players+upper)
+
+    size_t PairID(size_t a, size_t b) const {
+      return (a < b) ? (a * num_players + b) : (b * num_players + a);
+    }
+  public:
+    MatchHistory(size_t _num_players=0) { Reset(_num_players); }
+
+    void Reset(size_t _num_players) {
+      num_players = _num_players;
+      byes.resize(0);
+      byes.resize(num_players, 0);
+      met.clear();
+    }
+
+    size_t GetNumPlayers() const { return num_players; }
+    size_t GetByes(size_t player) const { return byes[player]; }
+    bool HaveMet(size_t a, size_t b) const { return met.count(PairID(a, b)); }
+
+    /// Record a round: mark each pair as having met and give a bye to anyone left out.
+    void AddRound(const emp::vector<MatchPair> & pairs) {
+      thread_local emp::vector<bool> played;
+      played.resize(0);
+      played.resize(num_players, false);
+      for (const MatchPair & pair : pairs) {
+        met.insert(PairID(pair.player0, pair.player1));
+        played[pair.player0] = played[pair.player1] = true;
+      }
+      for (size_t player = 0; player < num_players; ++player) {
+        if (!played[player]) ++byes[player];
+      }
+    }
+  };
+
+  /// With an odd number of players in order, remove the one who should sit out: the latest in
+  /// the order among those with the fewest byes so far.
+  inline void RemoveBye(emp::vector<size_t> & order, const MatchHistory & history) {
+    if (order.size() % 2 == 0) return;
+    size_t bye_pos = order.size() - 1;
+    for (size_t pos = bye_pos; pos-- > 0;) {
+      if (history.GetByes(order[pos]) < history.GetByes(order[bye_pos])) bye_pos = pos;
+    }
+    order.erase(order.begin() + (std::ptrdiff_t) bye_pos);
+  }
+
+  /// Fill pairs with a random pairing of num_players players.
+  inline void BuildRandomRound(size_t num_players, emp::Random & random,
+                               const MatchHistory & history, emp::vector<MatchPair> & pairs) {
+    emp_assert(history.GetNumPlayers() == num_players);
+    thread_local emp::vector<size_t> order;
+    order.resize(num_players);
+    std::iota(order.begin(), order.end(), 0);
+    for (size_t i = num_players; i > 1; --i) std::swap(order[i-1], order[random.GetUInt(i)]);
+    RemoveBye(order, history);
+    pairs.resize(0);
+    for (size_t i = 0; i + 1 < order.size(); i += 2) {
+      pairs.push_back(MatchPair{order[i], order[i+1]});
+    }
+  }
+
+  /// Fill pairs by ranking players by score (ties broken randomly); going down the ranking,
+  /// each unpaired player meets the next unpaired player they have not played yet (or simply
+  /// the next unpaired player, if they have played everyone left).
+  inline void BuildSwissRound(const emp::vector<double> & scores, emp::Random & random,
+                              const MatchHistory & history, emp::vector<MatchPair> & pairs) {
+    emp_assert(history.GetNumPlayers() == scores.size());
+    thread_local emp::vector<size_t> order;
+    thread_local emp::vector<size_t> tie_breaks;
+    const size_t num_players = scores.size();
+    order.resize(num_players);
+    tie_breaks.resize(num_players);
+    std::iota(order.begin(), order.end(), 0);
+    for (size_t & tie_break : tie_breaks) tie_break = random.GetUInt();
+    std::sort(order.begin(), order.end(), [&scores](size_t a, size_t b) {
+      if (scores[a] != scores[b]) return scores[a] > scores[b];
+      if (tie_breaks[a] != tie_breaks[b]) return tie_breaks[a] < tie_breaks[b];
+      return a < b;
+    });
+    RemoveBye(order, history);
+
+    // Pair from the top; order[0, next) holds players already paired (in ranked order).
+    pairs.resize(0);
+    for (size_t next = 0; next + 1 < order.size(); next += 2) {
+      const size_t player = order[next];
+      size_t opp_pos = next + 1;
+      while (opp_pos < order.size() && history.HaveMet(player, order[opp_pos])) ++opp_pos;
+      if (opp_pos == order.size()) opp_pos = next + 1;            // Rematch is unavoidable.
+      std::rotate(order.begin() + (std::ptrdiff_t) (next + 1),
+                  order.begin() + (std::ptrdiff_t) opp_pos,
+                  order.begin() + (std::ptrdiff_t) (opp_pos + 1));  // Keep the rest ranked.
+      pairs.push_back(MatchPair{player, order[next + 1]});
+    }
+  }
+
+  /// Run fun(job_id) for each job in [0, num_jobs) using up to num_threads threads (0 means one
+  /// per hardware thread).  Jobs are handed out in order as threads become free.
+  template <typename FUN_T>
+  void RunParallel(size_t num_jobs, size_t num_threads, FUN_T && fun) {
+    if (num_threads == 0) num_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    num_threads = std::min(num_threads, num_jobs);
+    if (num_threads <= 1) {
+      for (size_t job_id = 0; job_id < num_jobs; ++job_id) fun(job_id);
+      return;
+    }
+
+    std::atomic<size_t> next_job(0);
+    auto worker = [&next_job, num_jobs, &fun]() {
+      for (size_t job_id = next_job++; job_id < num_jobs; job_id = next_job++) fun(job_id);
+    };
+    emp::vector<std::thread> threads;
+    for (size_t i = 1; i < num_threads; ++i) threads.emplace_back(worker);
+    worker();                                   // This thread also takes jobs.
+    for (std::thread & thread : threads) thread.join();
+  }
+
+}
+
+#endif
@@ -13,10 +13,13 @@
 #ifndef EMP_EVO_NK_CONST_H
 #define EMP_EVO_NK_CONST_H
 
+#include <algorithm>
 #include <array>
+#include <cstdint>
 
 #include "emp/base/assert.hpp"
 #include "emp/bits/BitSet.hpp"
+#include "emp/bits/BitVector.hpp"
 #include "emp/math/math.hpp"
 #include "emp/math/Random.hpp"
 
@@ -50,7 +53,8 @@ namespace evo {
     std::array< std::array<double, state_count()>, N > landscape;
 
   public:
-    NKLandscapeConst() = delete; // { ; }
+    /// Build an empty landscape (all zeros), to be filled in with SetState().
+    NKLandscapeConst() : landscape() { ; }
 
     /// Build a new NKLandscapeConst using the random number generator [random]
     NKLandscapeConst(emp::Random & random) : landscape() {
@@ -82,6 +86,9 @@ namespace evo {
       return landscape[n][state];
     }
 
+    /// Set the fitness contribution of position [n] when it has the value [state].
+    void SetState(size_t n, size_t state, double in_fit) { landscape[n][state] = in_fit; }
+
     /// Get the fitness of a whole  bitstring
     double GetFitness( std::array<size_t, N> states ) const {
       double total = landscape[0][states[0]];
@@ -104,6 +111,37 @@ namespace evo {
       }
       return total;
     }
+
+    /// Get the fitness of a whole bitstring stored in a BitVector (which must have N bits).
+    /// Gene windows are read straight out of 64-bit chunks of the genome, so nothing is copied;
+    /// only the K genes that wrap around the end are assembled bit by bit.
+    double GetFitness(const BitVector & genome) const {
+      emp_assert(genome.GetSize() == N, genome.GetSize(), N);
+      constexpr size_t num_fields = (N + 31) / 32;
+      constexpr uint64_t mask = emp::MaskLow<uint64_t>(K+1);
+      constexpr size_t wrap_start = N - K;   // First gene whose window wraps around.
+
+      double total = 0.0;
+      size_t gene = 0;
+      for (size_t field = 0; gene < wrap_start; ++field) {
+        uint64_t window = genome.GetUInt(field);
+        if (field + 1 < num_fields) window |= ((uint64_t) genome.GetUInt(field+1)) << 32;
+        const size_t stop = std::min(wrap_start, gene + 32);
+        for (; gene < stop; ++gene) {
+          total += landscape[gene][window & mask];
+          window >>= 1;
+        }
+      }
+      for (; gene < N; ++gene) {
+        size_t state = 0;
+        for (size_t k = 0; k <= K; k++) {
+          const size_t pos = (gene + k < N) ? (gene + k) : (gene + k - N);
+          if (genome.Get(pos)) state |= ((size_t) 1) << k;
+        }
+        total += landscape[gene][state];
+      }
+      return total;
+    }
   };
 
 }
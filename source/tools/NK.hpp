@@ -12,6 +12,19 @@
  *  NKLandscape is faster, but goes up in memory size exponentially with K.  NKLandscapeMemo is
  *  slightly slower, but can handle arbitrarily large landscapes.
  *
+ *  NKLandscape stores all of its gene tables in a single flat array (optionally in single
+ *  precision, to halve memory use for large K).  Whole genomes are scored without copying:
+ *  each gene's K+1 bit window is pulled out of a 64-bit chunk of the genome with a shift and
+ *  a mask, and only the K genes that wrap around the end are assembled bit by bit.
+ *
+ *  NKLandscapeCached is meant for large K (where full tables would not fit in memory).  Each
+ *  gene's K+1 bit window is packed with the gene id into a single 64-bit key; fitness
+ *  contributions are generated from a hash of that key and the landscape seed, so they never
+ *  need to be stored.  Recently used values are kept in a fixed-size open-addressing cache;
+ *  since values are regenerated identically after being evicted, the cache bounds memory use
+ *  without changing the landscape.  (Lookups update the cache, so a single NKLandscapeCached
+ *  should not be shared between threads.)
+ *
  *  @todo Right now we make the library user decide between NKLandscape and NKLandscapeMemo.
  *    Based on K value, we should be able to do this automatically, so we could merge the two.
  */
@@ -19,12 +32,19 @@
 #ifndef MABE_TOOL_NK_H
 #define MABE_TOOL_NK_H
 
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#include "emp/base/assert.hpp"
 #include "emp/base/vector.hpp"
 #include "emp/bits/BitVector.hpp"
 #include "emp/functional/memo_function.hpp"
 #include "emp/math/math.hpp"
 #include "emp/math/Random.hpp"
 
+#include "StreamHash.hpp"
+
 namespace mabe {
 
   /// An NK Landscape is a popular tool for studying theoretical questions about evolutionary
@@ -51,21 +71,46 @@ namespace mabe {
     size_t K;             ///< The number of OTHER bits with which each bit is epistatic.
     size_t state_count;   ///< The total number of states associated with each bit table.
     size_t total_count;   ///< The total number of states in the entire landscape space.
-    emp::vector< emp::vector<double> > landscape;  ///< The actual values in the landscape.
+    bool use_float;       ///< Store the landscape in single precision to halve its memory?
+    emp::vector<double> landscape;        ///< All gene tables, back to back (gene-major).
+    emp::vector<float> landscape_float;   ///< Same as landscape, if single precision is used.
+
+    /// Sum the table entries for each gene in a genome.  Genes whose windows do not wrap around
+    /// the end of the genome are read 32 at a time out of a 64-bit chunk of the genome.
+    template <typename T>
+    double SumGenes(const T * table, const emp::BitVector & genome) const {
+      const size_t num_fields = (N + 31) / 32;
+      const uint64_t mask = emp::MaskLow<uint64_t>(K+1);
+      const size_t wrap_start = N - K;   // First gene whose window wraps around.
+      double total = 0.0;
+      size_t gene = 0;
+      for (size_t field = 0; gene < wrap_start; ++field) {
+        uint64_t window = genome.GetUInt(field);
+        if (field + 1 < num_fields) window |= ((uint64_t) genome.GetUInt(field+1)) << 32;
+        const size_t stop = std::min(wrap_start, gene + 32);
+        for (; gene < stop; ++gene) {
+          total += table[gene * state_count + (window & mask)];
+          window >>= 1;
+        }
+      }
+      for (; gene < N; ++gene) total += table[gene * state_count + GetState(genome, gene)];
+      return total;
+    }
 
   public:
-    NKLandscape() : N(0), K(0), state_count(0), total_count(0), landscape() { ; }
+    NKLandscape() : N(0), K(0), state_count(0), total_count(0), use_float(false), landscape() { ; }
     NKLandscape(const NKLandscape &) = default;
     NKLandscape(NKLandscape &&) = default;
 
     /// N is the length of bitstrings in your population, K is the number of neighboring sites
     /// the affect the fitness contribution of each site (i.e. epistasis or ruggedness), random
-    /// is the random number generator to use to generate this landscape.
-    NKLandscape(size_t _N, size_t _K, emp::Random & random)
+    /// is the random number generator to use to generate this landscape.  If _use_float is set,
+    /// fitness contributions are stored in single precision.
+    NKLandscape(size_t _N, size_t _K, emp::Random & random, bool _use_float=false)
      : N(_N), K(_K)
      , state_count(emp::IntPow<size_t>(2,K+1))
      , total_count(N * state_count)
-     , landscape(N)
+     , use_float(_use_float)
     {
       Reset(random);
     }
@@ -79,21 +124,25 @@ namespace mabe {
       emp_assert(K < N, K, N);
 
       // Build new landscape.
-      for ( auto & ltable : landscape) {
-        ltable.resize(state_count);
-        for (double & pos : ltable) {
-          pos = random.GetDouble();
-        }
+      if (use_float) {
+        landscape.resize(0);
+        landscape_float.resize(total_count);
+        for (float & pos : landscape_float) pos = (float) random.GetDouble();
+      }
+      else {
+        landscape_float.resize(0);
+        landscape.resize(total_count);
+        for (double & pos : landscape) pos = random.GetDouble();
       }
     }
 
     /// Configure for new values of N and K.
-    void Config(size_t _N, size_t _K, emp::Random & random) {
+    void Config(size_t _N, size_t _K, emp::Random & random, bool _use_float=false) {
       // Save new values.
       N = _N;  K = _K;
       state_count = emp::IntPow<size_t>(2,K+1);
       total_count = N * state_count;
-      landscape.resize(N);
+      use_float = _use_float;
       Reset(random);
     }
 
@@ -106,39 +155,49 @@ namespace mabe {
     /// Get the total number of states possible in the landscape
     /// (i.e. the number of different fitness contributions in the table)
     size_t GetTotalCount() const { return total_count; }
+    /// Are fitness contributions stored in single precision?
+    bool UsesFloat() const { return use_float; }
+
+    /// Get the state of gene [n] in a genome: bit n (in the lowest place) and the K bits after
+    /// it, wrapping around the end of the genome.
+    size_t GetState(const emp::BitVector & genome, size_t n) const {
+      emp_assert(genome.GetSize() == N, genome.GetSize(), N);
+      size_t state = 0;
+      for (size_t k = 0; k <= K; k++) {
+        const size_t pos = (n + k < N) ? (n + k) : (n + k - N);
+        if (genome.Get(pos)) state |= ((size_t) 1) << k;
+      }
+      return state;
+    }
 
     /// Get the fitness contribution of position [n] when it (and its K neighbors) have the value
     /// [state]
     double GetFitness(size_t n, size_t state) const {
       emp_assert(state < state_count, state, state_count);
-      return landscape[n][state];
+      const size_t id = n * state_count + state;
+      return use_float ? (double) landscape_float[id] : landscape[id];
     }
 
     /// Get the fitness of a whole  bitstring
     double GetFitness( std::vector<size_t> states ) const {
       emp_assert(states.size() == N);
-      double total = landscape[0][states[0]];
+      double total = GetFitness(0, states[0]);
       for (size_t i = 1; i < N; i++) total += GetFitness(i,states[i]);
       return total;
     }
 
-    /// Get the fitness of a whole bitstring (pass by value so can be modified.)
-    double GetFitness(emp::BitVector genome) const {
-      // Use a double-length genome to easily handle wrap-around.
-      genome.Resize(N*2);
-      genome |= (genome << N);
-
-      double total = 0.0;
-      size_t mask = emp::MaskLow<size_t>(K+1);
-      for (size_t i = 0; i < N; i++) {
-        const size_t cur_val = (genome >> i).GetUInt(0) & mask;
-	      const double cur_fit = GetFitness(i, cur_val);
-        total += cur_fit;
-      }
-      return total;
+    /// Get the fitness of a whole bitstring.
+    double GetFitness(const emp::BitVector & genome) const {
+      emp_assert(genome.GetSize() == N, genome.GetSize(), N);
+      if (use_float) return SumGenes(landscape_float.data(), genome);
+      return SumGenes(landscape.data(), genome);
     }
 
-    void SetState(size_t n, size_t state, double in_fit) { landscape[n][state] = in_fit; }
+    void SetState(size_t n, size_t state, double in_fit) {
+      const size_t id = n * state_count + state;
+      if (use_float) landscape_float[id] = (float) in_fit;
+      else landscape[id] = in_fit;
+    }
 
     void RandomizeStates(emp::Random & random, size_t num_states=1) {
       for (size_t i = 0; i < num_states; i++) {
@@ -198,6 +257,128 @@ namespace mabe {
     }
   };
 
+
+  /// NKLandscapeCached generates each fitness contribution on demand from the landscape seed,
+  /// gene id, and state (so any K up to 31 can be used with no tables), keeping recent values
+  /// in a bounded cache.
+  class NKLandscapeCached {
+  private:
+    static constexpr uint64_t EMPTY_KEY = std::numeric_limits<uint64_t>::max();
+    static constexpr size_t MAX_PROBES = 4;  ///< Cache slots to check before replacing one.
+
+    struct CacheEntry {
+      uint64_t key = EMPTY_KEY;   ///< Gene id (high 32 bits) and state (low 32 bits).
+      double value = 0.0;         ///< Fitness contribution for this gene and state.
+    };
+
+    size_t N = 0;           ///< The number of bits in each genome.
+    size_t K = 0;           ///< The number of OTHER bits with which each bit is epistatic.
+    uint64_t seed = 0;      ///< Seed that all fitness contributions are derived from.
+    mutable emp::vector<CacheEntry> cache;  ///< Recently used contributions.
+    size_t cache_mask = 0;  ///< Cache size minus one (cache size is a power of two).
+
+    static uint64_t MakeKey(size_t n, size_t state) { return (((uint64_t) n) << 32) | state; }
+
+    /// Produce the fitness contribution for a key, uniform in [0,1).
+    double GenerateValue(uint64_t key) const {
+      return (MixBits(key ^ seed) >> 11) * (1.0 / 9007199254740992.0);  // Keep 53 bits.
+    }
+
+    /// Find the fitness contribution for a key in the cache, generating (and caching) it if
+    /// needed.  If all probed slots are in use, the first one is replaced.
+    double Lookup(uint64_t key) const {
+      const size_t start = MixBits(key + 0x9e3779b97f4a7c15ULL) & cache_mask;
+      size_t open_slot = start;
+      for (size_t probe = 0; probe < MAX_PROBES; ++probe) {
+        CacheEntry & entry = cache[(start + probe) & cache_mask];
+        if (entry.key == key) return entry.value;
+        if (entry.key == EMPTY_KEY) { open_slot = (start + probe) & cache_mask; break; }
+      }
+      const double value = GenerateValue(key);
+      cache[open_slot].key = key;
+      cache[open_slot].value = value;
+      return value;
+    }
+
+  public:
+    NKLandscapeCached() = default;
+    NKLandscapeCached(const NKLandscapeCached &) = default;
+    NKLandscapeCached(NKLandscapeCached &&) = default;
+
+    /// Build a landscape for genomes of N bits where each gene uses K other bits; at most
+    /// 2^cache_bits fitness contributions are remembered at once.
+    NKLandscapeCached(size_t _N, size_t _K, emp::Random & random, size_t cache_bits=20) {
+      Config(_N, _K, random, cache_bits);
+    }
+    ~NKLandscapeCached() { ; }
+    NKLandscapeCached & operator=(const NKLandscapeCached &) = default;
+    NKLandscapeCached & operator=(NKLandscapeCached &&) = default;
+
+    /// Pick a new landscape seed (old contributions are discarded) without changing sizes.
+    void Reset(emp::Random & random) {
+      seed = (((uint64_t) random.GetUInt()) << 32) | random.GetUInt();
+      for (CacheEntry & entry : cache) entry = CacheEntry();
+    }
+
+    /// Configure for new values of N and K (and cache size).
+    void Config(size_t _N, size_t _K, emp::Random & random, size_t cache_bits=20) {
+      emp_assert(_K < 32, _K);
+      emp_assert(_K < _N, _K, _N);
+      emp_assert(cache_bits < 32, cache_bits);
+      N = _N;  K = _K;
+      cache.resize(0);
+      cache.resize(((size_t) 1) << cache_bits);
+      cache_mask = cache.size() - 1;
+      Reset(random);
+    }
+
+    size_t GetN() const { return N; }
+    size_t GetK() const { return K; }
+    size_t GetStateCount() const { return ((size_t) 1) << (K+1); }
+    size_t GetCacheSize() const { return cache.size(); }
+
+    /// Get the state of gene [n] in a genome: bit n (in the lowest place) and the K bits after
+    /// it, wrapping around the end of the genome.
+    size_t GetState(const emp::BitVector & genome, size_t n) const {
+      emp_assert(genome.GetSize() == N, genome.GetSize(), N);
+      size_t state = 0;
+      for (size_t k = 0; k <= K; k++) {
+        const size_t pos = (n + k < N) ? (n + k) : (n + k - N);
+        if (genome.Get(pos)) state |= ((size_t) 1) << k;
+      }
+      return state;
+    }
+
+    /// Get the fitness contribution of position [n] when it (and its K neighbors) have the value
+    /// [state]
+    double GetFitness(size_t n, size_t state) const {
+      emp_assert(n < N && state < GetStateCount(), n, N, state);
+      return Lookup(MakeKey(n, state));
+    }
+
+    /// Get the fitness of a whole bitstring; gene windows are read out of 64-bit chunks of the
+    /// genome (as in NKLandscape) and turned directly into cache keys.
+    double GetFitness(const emp::BitVector & genome) const {
+      emp_assert(genome.GetSize() == N, genome.GetSize(), N);
+      const size_t num_fields = (N + 31) / 32;
+      const uint64_t mask = emp::MaskLow<uint64_t>(K+1);
+      const size_t wrap_start = N - K;   // First gene whose window wraps around.
+      double total = 0.0;
+      size_t gene = 0;
+      for (size_t field = 0; gene < wrap_start; ++field) {
+        uint64_t window = genome.GetUInt(field);
+        if (field + 1 < num_fields) window |= ((uint64_t) genome.GetUInt(field+1)) << 32;
+        const size_t stop = std::min(wrap_start, gene + 32);
+        for (; gene < stop; ++gene) {
+          total += Lookup(MakeKey(gene, window & mask));
+          window >>= 1;
+        }
+      }
+      for (; gene < N; ++gene) total += Lookup(MakeKey(gene, GetState(genome, gene)));
+      return total;
+    }
+  };
+
 }
 
 #endif
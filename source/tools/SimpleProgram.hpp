@@ -0,0 +1,440 @@
+/**
+ *  @note This file is part of MABE, https://github.com/mercere99/MABE2
+ *  @copyright Copyright (C) Michigan State University, MIT Software license; see doc/LICENSE.md
+ *  @date 2021.
+ *
+ *  @file  SimpleProgram.hpp
+ *  @brief Fixed instruction set and fast interpreter for simple linear GP programs.
+ *  @note Status: ALPHA
+ *
+ *  Every instruction is exactly four bytes: an operation followed by three arguments.  Any
+ *  byte values are legal; operations are taken modulo NUM_OPS and arguments modulo 16, so
+ *  mutations never produce an invalid program.
+ *
+ *  Arguments refer to variables in a 1024-entry memory:
+ *    0-9   : registers (memory positions 0-9)
+ *    10-11 : internal memory, indexed by registers 4 and 5
+ *    12-13 : input memory (starting at MEM_INPUT_START), indexed by registers 6 and 7
+ *    14-15 : output memory (starting at MEM_OUTPUT_START), indexed by registers 8 and 9
+ *  The *_CONST instructions instead treat their second argument as an index into a fixed
+ *  table of constants (-2 through 512).
+ *
+ *  IF, WHILE, and COUNTDOWN each open a scope that is closed by the next matching END_SCOPE
+ *  (or by the end of the genome).  All scope structure is analyzed once per genome by
+ *  Compile(), which records a single jump target for every instruction that can change the
+ *  flow of control; execution then never has to search through the genome.
+ *    IF        : skip to the end of the scope if ARG1 is zero.
+ *    WHILE     : skip to the end of the scope if ARG1 is zero; END_SCOPE returns to the WHILE.
+ *    COUNTDOWN : like WHILE, but stops when ARG1 is <= 0, and decrements ARG1 on each entry.
+ *    BREAK     : leave the innermost loop (halt the program if not in a loop).
+ *    CONTINUE  : return to the start of the innermost loop (or the genome, if not in a loop).
+ *  Reaching the end of the genome loops back to the beginning; Run() always stops after the
+ *  provided number of steps.
+ *
+ *  Compile() can optionally strip introns: instructions that can never affect an output value
+ *  are found with a liveness analysis, and each run of them becomes a single INTRON step that
+ *  skips the whole run at once.  Skipped instructions are still charged one step each, so
+ *  stripped programs produce exactly the same outputs within the same step limit.
+ */
+
+#ifndef MABE_TOOL_SIMPLE_PROGRAM_H
+#define MABE_TOOL_SIMPLE_PROGRAM_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+#include "emp/base/assert.hpp"
+#include "emp/base/vector.hpp"
+
+namespace mabe {
+
+  class SimpleProgram {
+  public:
+    static constexpr size_t NUM_ARGS = 16;             ///< Number of distinct argument values.
+    static constexpr size_t NUM_REGS = 10;             ///< Registers directly addressable.
+    static constexpr size_t MEM_SIZE = 1024;
+    static constexpr size_t MEM_IO_SIZE = 256;
+    static constexpr size_t MEM_INPUT_START = 512;
+    static constexpr size_t MEM_OUTPUT_START = MEM_INPUT_START + MEM_IO_SIZE;
+    static constexpr size_t MEM_MASK = MEM_SIZE - 1;
+    static constexpr size_t IO_MASK = MEM_IO_SIZE - 1;
+    static constexpr size_t STACK_MASK = MEM_INPUT_START - 1;   ///< Stacks live in internal memory.
+    static_assert(MEM_OUTPUT_START + MEM_IO_SIZE <= MEM_SIZE, "IO must fit inside of memory.");
+
+    enum Op : uint8_t {
+      GET_CONST=0, ADD_CONST, MULT_CONST,  // (3) Modify ARG1 by constant ARG2
+      ADD, SUB, MULT, DIV, MOD, NAND,      // (6) Basic two-input math (ARG3 = ARG1 op ARG2)
+      TEST_EQU, TEST_NEQU, TEST_LESS,      // (3) Compare ARG1 and ARG2; put 0/1 result in ARG3
+      COPY,                                // (1) Copy ARG1 into ARG2
+      IF, WHILE, COUNTDOWN,                // (3) Open a scope, conditional on ARG1
+      CONTINUE, BREAK, END_SCOPE,          // (3) Flow control within scopes
+      PUSH, POP,                           // (2) Treat ARG1 as stack pointer; push/pop with ARG2
+      NUM_OPS,                             // 21 - Number of operations in the instruction set
+      INTRON = NUM_OPS                     // Compiled only: a run of insts with no effect on outputs
+    };
+
+    /// A single instruction, as stored in a genome.
+    struct Inst {
+      uint8_t op = 0;
+      uint8_t args[3] = {0, 0, 0};
+    };
+    static_assert(sizeof(Inst) == 4, "Instructions must be packed into four bytes.");
+
+    /// Execution state for running a program; reusable across programs.
+    struct State {
+      double mem[MEM_SIZE];
+      size_t inst_ptr = 0;
+
+      State() { Reset(); }
+
+      void Reset() {
+        std::fill(mem, mem + MEM_SIZE, 0.0);
+        inst_ptr = 0;
+      }
+
+      /// Copy inputs into input memory (extra inputs beyond MEM_IO_SIZE are ignored).
+      template <typename VEC_T>
+      void SetInputs(const VEC_T & inputs) {
+        const size_t count = std::min<size_t>(inputs.size(), MEM_IO_SIZE);
+        std::copy(inputs.begin(), inputs.begin() + count, mem + MEM_INPUT_START);
+      }
+
+      double GetOutput(size_t id) const { return mem[MEM_OUTPUT_START + (id & IO_MASK)]; }
+
+      /// Copy the first count outputs into out.
+      void GetOutputs(double * out, size_t count) const {
+        emp_assert(count <= MEM_IO_SIZE, count);
+        std::copy(mem + MEM_OUTPUT_START, mem + MEM_OUTPUT_START + count, out);
+      }
+    };
+
+    static constexpr uint32_t NO_TARGET = (uint32_t) -1;  ///< Jump target that halts execution.
+
+    /// A decoded instruction with its pre-computed jump target.
+    struct Step {
+      uint8_t op;
+      uint8_t args[3];
+      uint32_t target;   ///< Where to go when this instruction changes the flow of control
+                         ///< (or, for INTRON, the number of introns in a row starting here).
+    };
+
+    /// Convert a value to a memory index (wrapping negatives); NaN and huge values give zero.
+    static size_t ToIndex(double value) {
+      if (!(value > -2147483648.0 && value < 2147483648.0)) return 0;
+      return (size_t) (int64_t) value;
+    }
+
+    static uint32_t ToBits(double value) { return (uint32_t) ToIndex(value); }
+
+    static double GetConst(uint8_t arg) {
+      static constexpr double consts[NUM_ARGS] =
+        { -2.0, -1.0, 0.0, 0.25, 0.5, 1.0, 2.0, 3.0, 4.0, 8.0, 16.0, 32.0, 64.0, 128.0, 256.0, 512.0 };
+      return consts[arg];
+    }
+
+    /// Memory position referred to by an argument, given a way to read the index registers.
+    template <typename REG_FUN>
+    static size_t GetVarPos(uint8_t arg, REG_FUN && get_reg) {
+      // Base memory position and index mask for each of the six indirect arguments.
+      static constexpr size_t ind_base[6] =
+        { 0, 0, MEM_INPUT_START, MEM_INPUT_START, MEM_OUTPUT_START, MEM_OUTPUT_START };
+      static constexpr size_t ind_mask[6] =
+        { STACK_MASK, STACK_MASK, IO_MASK, IO_MASK, IO_MASK, IO_MASK };
+
+      if (arg < NUM_REGS) return arg;
+      const size_t ind = arg - NUM_REGS;
+      return ind_base[ind] + (ToIndex(get_reg(ind + 4)) & ind_mask[ind]);
+    }
+
+  private:
+    emp::vector<Step> code;
+    size_t num_effective = 0;   ///< Number of instructions that can affect outputs.
+    bool compiled = false;
+
+    // Abstract memory locations used when finding introns: each register, plus the rest of
+    // internal memory, input memory, and output memory as single blocks.
+    static constexpr uint32_t LOC_REGS = (1u << NUM_REGS) - 1;
+    static constexpr uint32_t LOC_INTERNAL = 1u << NUM_REGS;
+    static constexpr uint32_t LOC_INPUT = 1u << (NUM_REGS + 1);
+    static constexpr uint32_t LOC_OUTPUT = 1u << (NUM_REGS + 2);
+
+    /// Register used to index memory for an indirect argument (none for registers).
+    static uint32_t IndexLoc(uint8_t arg) { return (arg < NUM_REGS) ? 0 : 1u << (arg - 6); }
+
+    /// Locations that an argument might refer to.
+    static uint32_t ArgLocs(uint8_t arg) {
+      if (arg < NUM_REGS) return 1u << arg;
+      if (arg < 12) return LOC_REGS | LOC_INTERNAL;   // Internal memory can include registers.
+      if (arg < 14) return LOC_INPUT;
+      return LOC_OUTPUT;
+    }
+
+    /// Locations read when an argument is used as an input.
+    static uint32_t UseLocs(uint8_t arg) { return ArgLocs(arg) | IndexLoc(arg); }
+
+    /// Location definitely overwritten when an argument is used as a destination.
+    static uint32_t KillLocs(uint8_t arg) { return (arg < NUM_REGS) ? 1u << arg : 0; }
+
+    /// Find all instructions that cannot affect outputs (using backward liveness analysis
+    /// over the control-flow graph), and replace each run of them with a single INTRON step.
+    /// Flow-control instructions are always kept, so the path through the program is unchanged.
+    void MarkIntrons() {
+      const size_t size = code.size();
+      emp::vector<uint32_t> uses(size, 0), defs(size, 0), kills(size, 0), live_in(size, 0);
+      emp::vector<bool> flow(size, false);
+
+      for (size_t pos = 0; pos < size; ++pos) {
+        const Step & step = code[pos];
+        const uint8_t a1 = step.args[0], a2 = step.args[1], a3 = step.args[2];
+        switch (step.op) {
+        case GET_CONST:
+          uses[pos] = IndexLoc(a1); defs[pos] = ArgLocs(a1); kills[pos] = KillLocs(a1); break;
+        case ADD_CONST: case MULT_CONST:
+          uses[pos] = UseLocs(a1); defs[pos] = ArgLocs(a1); break;
+        case ADD: case SUB: case MULT: case NAND: case TEST_EQU: case TEST_NEQU: case TEST_LESS:
+          uses[pos] = UseLocs(a1) | UseLocs(a2) | IndexLoc(a3);
+          defs[pos] = ArgLocs(a3); kills[pos] = KillLocs(a3);
+          break;
+        case DIV: case MOD:   // Destination is not written if dividing by zero, so no kill.
+          uses[pos] = UseLocs(a1) | UseLocs(a2) | IndexLoc(a3); defs[pos] = ArgLocs(a3); break;
+        case COPY:
+          uses[pos] = UseLocs(a1) | IndexLoc(a2); defs[pos] = ArgLocs(a2); kills[pos] = KillLocs(a2);
+          break;
+        case PUSH:
+          uses[pos] = UseLocs(a1) | UseLocs(a2); defs[pos] = ArgLocs(a1) | LOC_REGS | LOC_INTERNAL;
+          break;
+        case POP:
+          uses[pos] = UseLocs(a1) | LOC_REGS | LOC_INTERNAL | IndexLoc(a2);
+          defs[pos] = ArgLocs(a1) | ArgLocs(a2);
+          break;
+        case IF: case WHILE: case COUNTDOWN:
+          uses[pos] = UseLocs(a1); flow[pos] = true; break;
+        default:   // CONTINUE, BREAK, END_SCOPE
+          flow[pos] = true;
+        }
+      }
+
+      // Locations live just after an instruction: outputs, plus whatever is live where it leads.
+      auto live_out = [this, size, &live_in](size_t pos) {
+        const Step & step = code[pos];
+        const size_t next = (pos + 1 < size) ? pos + 1 : 0;
+        const size_t target = (step.target < size) ? step.target : 0;
+        uint32_t live = LOC_OUTPUT;
+        switch (step.op) {
+        case IF: case WHILE: case COUNTDOWN: live |= live_in[next] | live_in[target]; break;
+        case CONTINUE: case END_SCOPE:       live |= live_in[target]; break;
+        case BREAK: if (step.target != NO_TARGET) live |= live_in[target]; break;
+        default:                             live |= live_in[next];
+        }
+        return live;
+      };
+
+      // Iterate backward passes until nothing changes; loops and wrap-around make this necessary.
+      emp::vector<bool> effective(size, false);
+      bool changed = true;
+      while (changed) {
+        changed = false;
+        for (size_t pos = size; pos > 0; --pos) {
+          const size_t i = pos - 1;
+          const uint32_t live = live_out(i);
+          effective[i] = flow[i] || (defs[i] & live);
+          const uint32_t new_in = effective[i] ? ((live & ~kills[i]) | uses[i]) : live;
+          if (new_in != live_in[i]) { live_in[i] = new_in; changed = true; }
+        }
+      }
+
+      // Mark introns, recording the length of each run (runs stop at the end of the genome).
+      num_effective = 0;
+      uint32_t run_length = 0;
+      for (size_t pos = size; pos > 0; --pos) {
+        Step & step = code[pos-1];
+        if (effective[pos-1]) { run_length = 0; ++num_effective; continue; }
+        step.op = INTRON;
+        step.target = ++run_length;
+      }
+    }
+
+    static double & GetVar(State & state, uint8_t arg) {
+      double * mem = state.mem;
+      return mem[GetVarPos(arg, [mem](size_t reg){ return mem[reg]; })];
+    }
+
+  public:
+    SimpleProgram() = default;
+    SimpleProgram(const SimpleProgram &) = default;
+    SimpleProgram(SimpleProgram &&) = default;
+    SimpleProgram & operator=(const SimpleProgram &) = default;
+    SimpleProgram & operator=(SimpleProgram &&) = default;
+
+    static const std::string & GetName(size_t op) {
+      static const std::string names[NUM_OPS+1] = {
+        "GetConst", "AddConst", "MultConst", "Add", "Sub", "Mult", "Div", "Mod", "Nand",
+        "TestEqu", "TestNEqu", "TestLess", "Copy", "If", "While", "Countdown",
+        "Continue", "Break", "EndScope", "Push", "Pop", "Unknown"
+      };
+      return names[std::min<size_t>(op, NUM_OPS)];
+    }
+
+    /// Is this operation one that opens a new scope?
+    static bool IsScopeStart(uint8_t op) { return op == IF || op == WHILE || op == COUNTDOWN; }
+    static bool IsLoop(uint8_t op) { return op == WHILE || op == COUNTDOWN; }
+
+    bool IsCompiled() const { return compiled; }
+    size_t GetSize() const { return code.size(); }
+    size_t GetEffectiveSize() const { return num_effective; }
+    const emp::vector<Step> & GetCode() const { return code; }
+    void Invalidate() { compiled = false; }
+
+    /// Decode a genome and pre-compute all jump targets for it.  If strip_introns is set, also
+    /// find instructions that cannot affect outputs so that Run() can skip over them.
+    template <typename SEQUENCE_T>
+    void Compile(const SEQUENCE_T & genome, bool strip_introns=false) {
+      const size_t size = genome.size();
+      emp_assert(size < (size_t) NO_TARGET, size);
+      code.resize(size);
+      for (size_t pos = 0; pos < size; ++pos) {
+        code[pos].op = genome[pos].op % NUM_OPS;
+        for (size_t i = 0; i < 3; ++i) code[pos].args[i] = genome[pos].args[i] % NUM_ARGS;
+        code[pos].target = NO_TARGET;
+      }
+
+      // Match scopes with a stack of open scope starts.  By default, unclosed scopes end at the
+      // end of the genome (where execution wraps back to the beginning).
+      emp::vector<uint32_t> open_scopes;
+      for (size_t pos = 0; pos < size; ++pos) {
+        Step & step = code[pos];
+        switch (step.op) {
+        case IF: case WHILE: case COUNTDOWN:
+          step.target = (uint32_t) size;
+          open_scopes.push_back((uint32_t) pos);
+          break;
+        case END_SCOPE:
+          if (open_scopes.size() == 0) { step.target = (uint32_t) pos + 1; break; }  // No-op
+          code[open_scopes.back()].target = (uint32_t) pos + 1;
+          step.target = IsLoop(code[open_scopes.back()].op) ? open_scopes.back() : (uint32_t) pos + 1;
+          open_scopes.pop_back();
+          break;
+        case CONTINUE:
+        case BREAK:
+          step.target = NO_TARGET;
+          for (size_t i = open_scopes.size(); i > 0; --i) {
+            if (IsLoop(code[open_scopes[i-1]].op)) { step.target = open_scopes[i-1]; break; }
+          }
+          if (step.op == CONTINUE && step.target == NO_TARGET) step.target = 0;
+          break;
+        default:
+          break;
+        }
+      }
+
+      // BREAK targets must go to the END of their loop; now that all loop ends are known, update.
+      for (Step & step : code) {
+        if (step.op == BREAK && step.target != NO_TARGET) step.target = code[step.target].target;
+      }
+
+      num_effective = size;
+      if (strip_introns) MarkIntrons();
+      compiled = true;
+    }
+
+    /// Run for up to max_steps instructions (continuing from the state's current position).
+    /// Returns the number of steps actually executed (fewer if the program halted).
+    size_t Run(State & state, size_t max_steps) const {
+      emp_assert(compiled);
+      const size_t size = code.size();
+      if (size == 0) return 0;
+
+      const Step * steps = code.data();
+      size_t ip = state.inst_ptr;
+      size_t step_count = 0;
+
+      while (step_count < max_steps) {
+        if (ip >= size) ip = 0;
+        const Step & step = steps[ip++];
+        ++step_count;
+
+        const uint8_t a1 = step.args[0];
+        const uint8_t a2 = step.args[1];
+        const uint8_t a3 = step.args[2];
+
+        switch (step.op) {
+        case GET_CONST:  GetVar(state, a1) = GetConst(a2); break;
+        case ADD_CONST:  GetVar(state, a1) += GetConst(a2); break;
+        case MULT_CONST: GetVar(state, a1) *= GetConst(a2); break;
+        case ADD:  GetVar(state, a3) = GetVar(state, a1) + GetVar(state, a2); break;
+        case SUB:  GetVar(state, a3) = GetVar(state, a1) - GetVar(state, a2); break;
+        case MULT: GetVar(state, a3) = GetVar(state, a1) * GetVar(state, a2); break;
+        case DIV: {
+          const double denom = GetVar(state, a2);
+          if (denom != 0.0) GetVar(state, a3) = GetVar(state, a1) / denom;
+          break;
+        }
+        case MOD: {
+          const double denom = GetVar(state, a2);
+          if (denom != 0.0) GetVar(state, a3) = std::fmod(GetVar(state, a1), denom);
+          break;
+        }
+        case NAND:
+          GetVar(state, a3) = (double) (uint32_t) ~(ToBits(GetVar(state, a1)) & ToBits(GetVar(state, a2)));
+          break;
+        case TEST_EQU:  GetVar(state, a3) = (GetVar(state, a1) == GetVar(state, a2)); break;
+        case TEST_NEQU: GetVar(state, a3) = (GetVar(state, a1) != GetVar(state, a2)); break;
+        case TEST_LESS: GetVar(state, a3) = (GetVar(state, a1) < GetVar(state, a2)); break;
+        case COPY: GetVar(state, a2) = GetVar(state, a1); break;
+
+        case IF:
+        case WHILE:
+          if (GetVar(state, a1) == 0.0) ip = step.target;
+          break;
+        case COUNTDOWN: {
+          double & counter = GetVar(state, a1);
+          if (counter > 0.0) counter -= 1.0;
+          else ip = step.target;
+          break;
+        }
+        case CONTINUE:
+        case END_SCOPE:
+          ip = step.target;
+          break;
+        case BREAK:
+          if (step.target == NO_TARGET) {     // Not in a loop; halt.
+            state.inst_ptr = 0;
+            return step_count;
+          }
+          ip = step.target;
+          break;
+
+        case PUSH: {
+          double & stack_ptr = GetVar(state, a1);
+          state.mem[ToIndex(stack_ptr) & STACK_MASK] = GetVar(state, a2);
+          stack_ptr += 1.0;
+          break;
+        }
+        case POP: {
+          double & stack_ptr = GetVar(state, a1);
+          stack_ptr -= 1.0;
+          GetVar(state, a2) = state.mem[ToIndex(stack_ptr) & STACK_MASK];
+          break;
+        }
+        case INTRON: {
+          // Skip the rest of this run of introns, charging one step for each.
+          const size_t skip = std::min<size_t>(step.target - 1, max_steps - step_count);
+          ip += skip;
+          step_count += skip;
+          break;
+        }
+        default:
+          emp_assert(false, "Unknown SimpleProgram operation.", (size_t) step.op);
+        }
+      }
+
+      state.inst_ptr = ip;
+      return step_count;
+    }
+  };
+
+}
+
+#endif
@@ -0,0 +1,355 @@
+/**
+ *  @note This file is part of MABE, https://github.com/mercere99/MABE2
+ *  @copyright Copyright (C) Michigan State University, MIT Software license; see doc/LICENSE.md
+ *  @date 2021.
+ *
+ *  @file  SimpleProgramLanes.hpp
+ *  @brief Run one SimpleProgram on many input sets at once, one lane per input set.
+ *  @note Status: ALPHA
+ *
+ *  Memory is stored lane-interleaved (structure-of-arrays): memory position p for lane l is
+ *  at mem[p * LANES + l].  Each instruction is executed for all lanes in a single loop over
+ *  contiguous values; for register-only arguments these loops have no data-dependent branches
+ *  and are vectorized by the compiler.  Lanes that are not currently executing an instruction
+ *  are masked out with a select rather than a branch.
+ *
+ *  Each lane keeps its own instruction pointer and step count.  On every step the engine runs
+ *  the lowest instruction pointer among the lanes still running, for all lanes at that
+ *  position.  Lanes that diverge on a branch therefore wait at the first instruction past it
+ *  until the others catch up (e.g., lanes that leave a loop early wait at its end), and every
+ *  lane executes exactly the same instruction sequence it would in SimpleProgram::Run(); the
+ *  results are identical, including the max_steps cut-off.
+ *
+ *  Lanes can hold different input cases for one organism, or different organisms that share
+ *  the same genome; see SimpleProgramOrg for both uses.
+ */
+
+#ifndef MABE_TOOL_SIMPLE_PROGRAM_LANES_H
+#define MABE_TOOL_SIMPLE_PROGRAM_LANES_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "emp/base/assert.hpp"
+#include "emp/base/vector.hpp"
+
+#include "SimpleProgram.hpp"
+
+namespace mabe {
+
+  template <size_t LANES=8>
+  class SimpleProgramLanes {
+  public:
+    static constexpr size_t NUM_LANES = LANES;
+    static constexpr size_t MEM_SIZE = SimpleProgram::MEM_SIZE;
+
+  private:
+    using Step = SimpleProgram::Step;
+
+    emp::vector<double> mem;      ///< Lane-interleaved memory; MEM_SIZE * LANES values.
+    size_t inst_ptr[LANES];       ///< Next instruction for each lane.
+    size_t step_count[LANES];     ///< Instructions executed by each lane.
+    bool live[LANES];             ///< Is this lane still running?
+    size_t num_lanes = 0;         ///< Lanes in use for the current run.
+
+    double * Row(size_t pos) { return mem.data() + pos * LANES; }
+    double & Var(size_t lane, uint8_t arg) {
+      const size_t pos = SimpleProgram::GetVarPos(arg,
+        [this, lane](size_t reg){ return mem[reg * LANES + lane]; });
+      return mem[pos * LANES + lane];
+    }
+
+    /// Set z = fun(x, y, z) in all active lanes, with x, y, and z given by arguments.
+    template <typename FUN>
+    void Apply(const bool * active, uint8_t a1, uint8_t a2, uint8_t a3, FUN && fun) {
+      if (a1 < SimpleProgram::NUM_REGS && a2 < SimpleProgram::NUM_REGS
+          && a3 < SimpleProgram::NUM_REGS) {
+        // Fast path: all registers, so each argument is one contiguous row.
+        const double * x = Row(a1);
+        const double * y = Row(a2);
+        double * z = Row(a3);
+        for (size_t l = 0; l < LANES; ++l) {
+          const double result = fun(x[l], y[l], z[l]);
+          z[l] = active[l] ? result : z[l];
+        }
+        return;
+      }
+      for (size_t l = 0; l < LANES; ++l) {
+        if (!active[l]) continue;
+        const double x = Var(l, a1);
+        const double y = Var(l, a2);
+        double & z = Var(l, a3);
+        z = fun(x, y, z);
+      }
+    }
+
+    /// Set x = fun(x, c) in all active lanes, for constant c.
+    template <typename FUN>
+    void ApplyConst(const bool * active, uint8_t a1, double c, FUN && fun) {
+      if (a1 < SimpleProgram::NUM_REGS) {
+        double * x = Row(a1);
+        for (size_t l = 0; l < LANES; ++l) {
+          const double result = fun(x[l], c);
+          x[l] = active[l] ? result : x[l];
+        }
+        return;
+      }
+      for (size_t l = 0; l < LANES; ++l) {
+        if (active[l]) { double & x = Var(l, a1); x = fun(x, c); }
+      }
+    }
+
+    /// Execute one instruction (at position ip) in all active lanes.  Returns true if all of
+    /// those lanes simply move on to the next instruction; otherwise each active lane's new
+    /// instruction pointer has been set (and lanes that halted are no longer live).
+    bool Execute(const Step & step, const bool * active, size_t ip, size_t size) {
+      const uint8_t a1 = step.args[0];
+      const uint8_t a2 = step.args[1];
+      const uint8_t a3 = step.args[2];
+      const size_t next_ip = (ip + 1 < size) ? ip + 1 : 0;
+      const size_t target_ip = (step.target < size) ? step.target : 0;  // Wrap if at end.
+
+      switch (step.op) {
+      case SimpleProgram::GET_CONST:
+        ApplyConst(active, a1, SimpleProgram::GetConst(a2), [](double, double c){ return c; });
+        break;
+      case SimpleProgram::ADD_CONST:
+        ApplyConst(active, a1, SimpleProgram::GetConst(a2), [](double x, double c){ return x + c; });
+        break;
+      case SimpleProgram::MULT_CONST:
+        ApplyConst(active, a1, SimpleProgram::GetConst(a2), [](double x, double c){ return x * c; });
+        break;
+      case SimpleProgram::ADD:
+        Apply(active, a1, a2, a3, [](double x, double y, double){ return x + y; });
+        break;
+      case SimpleProgram::SUB:
+        Apply(active, a1, a2, a3, [](double x, double y, double){ return x - y; });
+        break;
+      case SimpleProgram::MULT:
+        Apply(active, a1, a2, a3, [](double x, double y, double){ return x * y; });
+        break;
+      case SimpleProgram::DIV:
+        Apply(active, a1, a2, a3, [](double x, double y, double z){ return (y != 0.0) ? x / y : z; });
+        break;
+      case SimpleProgram::MOD:
+        Apply(active, a1, a2, a3,
+              [](double x, double y, double z){ return (y != 0.0) ? std::fmod(x, y) : z; });
+        break;
+      case SimpleProgram::NAND:
+        Apply(active, a1, a2, a3, [](double x, double y, double){
+          return (double) (uint32_t) ~(SimpleProgram::ToBits(x) & SimpleProgram::ToBits(y));
+        });
+        break;
+      case SimpleProgram::TEST_EQU:
+        Apply(active, a1, a2, a3, [](double x, double y, double){ return (double) (x == y); });
+        break;
+      case SimpleProgram::TEST_NEQU:
+        Apply(active, a1, a2, a3, [](double x, double y, double){ return (double) (x != y); });
+        break;
+      case SimpleProgram::TEST_LESS:
+        Apply(active, a1, a2, a3, [](double x, double y, double){ return (double) (x < y); });
+        break;
+      case SimpleProgram::COPY:
+        for (size_t l = 0; l < LANES; ++l) {
+          if (active[l]) { const double x = Var(l, a1); Var(l, a2) = x; }
+        }
+        break;
+
+      case SimpleProgram::IF:
+      case SimpleProgram::WHILE:
+        for (size_t l = 0; l < LANES; ++l) {
+          if (active[l]) inst_ptr[l] = (Var(l, a1) == 0.0) ? target_ip : next_ip;
+        }
+        return false;
+      case SimpleProgram::COUNTDOWN:
+        for (size_t l = 0; l < LANES; ++l) {
+          if (!active[l]) continue;
+          double & counter = Var(l, a1);
+          if (counter > 0.0) { counter -= 1.0; inst_ptr[l] = next_ip; }
+          else inst_ptr[l] = target_ip;
+        }
+        return false;
+      case SimpleProgram::CONTINUE:
+      case SimpleProgram::END_SCOPE:
+        for (size_t l = 0; l < LANES; ++l) if (active[l]) inst_ptr[l] = target_ip;
+        return false;
+      case SimpleProgram::BREAK:
+        for (size_t l = 0; l < LANES; ++l) {
+          if (!active[l]) continue;
+          if (step.target == SimpleProgram::NO_TARGET) live[l] = false;   // Halt.
+          else inst_ptr[l] = target_ip;
+        }
+        return false;
+
+      case SimpleProgram::PUSH:
+        for (size_t l = 0; l < LANES; ++l) {
+          if (!active[l]) continue;
+          double & stack_ptr = Var(l, a1);
+          const double value = Var(l, a2);
+          mem[(SimpleProgram::ToIndex(stack_ptr) & SimpleProgram::STACK_MASK) * LANES + l] = value;
+          stack_ptr += 1.0;
+        }
+        break;
+      case SimpleProgram::POP:
+        for (size_t l = 0; l < LANES; ++l) {
+          if (!active[l]) continue;
+          double & stack_ptr = Var(l, a1);
+          stack_ptr -= 1.0;
+          const double value = mem[(SimpleProgram::ToIndex(stack_ptr) & SimpleProgram::STACK_MASK) * LANES + l];
+          Var(l, a2) = value;
+        }
+        break;
+      default:
+        emp_assert(false, "Unknown SimpleProgram operation.", (size_t) step.op);
+      }
+      return true;
+    }
+
+  public:
+    SimpleProgramLanes() : mem(MEM_SIZE * LANES, 0.0) { Reset(0); }
+
+    size_t GetNumLanes() const { return num_lanes; }
+
+    /// Clear all memory and prepare to run the given number of lanes.
+    void Reset(size_t in_lanes) {
+      emp_assert(in_lanes <= LANES, in_lanes, LANES);
+      std::fill(mem.begin(), mem.end(), 0.0);
+      num_lanes = in_lanes;
+      for (size_t l = 0; l < LANES; ++l) {
+        inst_ptr[l] = 0;
+        step_count[l] = 0;
+        live[l] = false;
+      }
+    }
+
+    /// Load inputs for a single lane.
+    template <typename VEC_T>
+    void SetInputs(size_t lane, const VEC_T & inputs) {
+      emp_assert(lane < num_lanes, lane, num_lanes);
+      const size_t count = std::min<size_t>(inputs.size(), SimpleProgram::MEM_IO_SIZE);
+      double * base = Row(SimpleProgram::MEM_INPUT_START) + lane;
+      for (size_t i = 0; i < count; ++i) base[i * LANES] = inputs[i];
+    }
+
+    double GetOutput(size_t lane, size_t id) const {
+      return mem[(SimpleProgram::MEM_OUTPUT_START + (id & SimpleProgram::IO_MASK)) * LANES + lane];
+    }
+
+    /// Copy the first count outputs of a lane into out.
+    void GetOutputs(size_t lane, double * out, size_t count) const {
+      emp_assert(count <= SimpleProgram::MEM_IO_SIZE, count);
+      const double * base = mem.data() + SimpleProgram::MEM_OUTPUT_START * LANES + lane;
+      for (size_t i = 0; i < count; ++i) out[i] = base[i * LANES];
+    }
+
+    size_t GetStepCount(size_t lane) const { return step_count[lane]; }
+
+    /// Run the program in all lanes in use, each for up to max_steps instructions.
+    void Run(const SimpleProgram & program, size_t max_steps) {
+      const emp::vector<Step> & code = program.GetCode();
+      const size_t size = code.size();
+      if (size == 0 || max_steps == 0) return;
+
+      for (size_t l = 0; l < num_lanes; ++l) live[l] = step_count[l] < max_steps;
+      bool active[LANES];
+
+      while (true) {
+        // Find the next position to run: the lowest among running lanes.
+        size_t ip = size;
+        for (size_t l = 0; l < LANES; ++l) if (live[l] && inst_ptr[l] < ip) ip = inst_ptr[l];
+        if (ip == size) break;   // No lanes left running.
+
+        bool converged = true;
+        size_t budget = max_steps;
+        for (size_t l = 0; l < LANES; ++l) {
+          active[l] = live[l] && inst_ptr[l] == ip;
+          if (live[l] && !active[l]) converged = false;
+          if (active[l]) budget = std::min(budget, max_steps - step_count[l]);
+        }
+
+        // If lanes have diverged, advance only the ones at this position by a single step.
+        if (!converged) {
+          if (code[ip].op == SimpleProgram::INTRON) {
+            // Lanes may have different amounts of time left, so skip introns lane-by-lane.
+            for (size_t l = 0; l < LANES; ++l) {
+              if (!active[l]) continue;
+              const size_t skip = std::min<size_t>(code[ip].target - 1, max_steps - step_count[l] - 1);
+              inst_ptr[l] = (ip + 1 + skip < size) ? ip + 1 + skip : 0;
+              step_count[l] += 1 + skip;
+              if (step_count[l] >= max_steps) live[l] = false;
+            }
+            continue;
+          }
+          if (Execute(code[ip], active, ip, size)) {
+            const size_t next_ip = (ip + 1 < size) ? ip + 1 : 0;
+            for (size_t l = 0; l < LANES; ++l) if (active[l]) inst_ptr[l] = next_ip;
+          }
+          for (size_t l = 0; l < LANES; ++l) {
+            if (active[l] && ++step_count[l] >= max_steps) live[l] = false;
+          }
+          continue;
+        }
+
+        // All running lanes are together; run them as a group until they split up (or the
+        // first of them runs out of time) without tracking each lane's position.
+        size_t num_steps = 0;
+        while (num_steps < budget) {
+          ++num_steps;
+          if (code[ip].op == SimpleProgram::INTRON) {
+            const size_t skip = std::min<size_t>(code[ip].target - 1, budget - num_steps);
+            ip = (ip + 1 + skip < size) ? ip + 1 + skip : 0;
+            num_steps += skip;
+            continue;
+          }
+          if (Execute(code[ip], active, ip, size)) {
+            ip = (ip + 1 < size) ? ip + 1 : 0;
+            continue;
+          }
+
+          // Flow control; see if all lanes went to the same place.
+          size_t new_ip = size;
+          for (size_t l = 0; l < LANES; ++l) {
+            if (!active[l]) continue;
+            if (!live[l]) {                       // Halted by this instruction.
+              step_count[l] += num_steps;
+              active[l] = false;
+            }
+            else if (new_ip == size) new_ip = inst_ptr[l];
+            else if (inst_ptr[l] != new_ip) converged = false;
+          }
+          if (!converged || new_ip == size) break;
+          ip = new_ip;
+        }
+
+        for (size_t l = 0; l < LANES; ++l) {
+          if (!active[l]) continue;
+          if (converged) inst_ptr[l] = ip;
+          step_count[l] += num_steps;
+          if (step_count[l] >= max_steps) live[l] = false;
+        }
+      }
+    }
+
+    /// Run the program on each input case (LANES cases at a time), writing outputs into a
+    /// case-by-output matrix: out[case * num_outputs + output_id].
+    void RunBatch(const SimpleProgram & program, const emp::vector<emp::vector<double>> & inputs,
+                  size_t max_steps, double * out, size_t num_outputs) {
+      const size_t copy_count = std::min(num_outputs, SimpleProgram::MEM_IO_SIZE);
+      for (size_t start = 0; start < inputs.size(); start += LANES) {
+        const size_t count = std::min(LANES, inputs.size() - start);
+        Reset(count);
+        for (size_t l = 0; l < count; ++l) SetInputs(l, inputs[start + l]);
+        Run(program, max_steps);
+        for (size_t l = 0; l < count; ++l) {
+          double * case_out = out + (start + l) * num_outputs;
+          GetOutputs(l, case_out, copy_count);
+          std::fill(case_out + copy_count, case_out + num_outputs, 0.0);
+        }
+      }
+    }
+  };
+
+}
+
+#endif
@@ -0,0 +1,57 @@
+/**
+ *  @note This file is part of MABE, https://github.com/mercere99/MABE2
+ *  @copyright Copyright (C) Michigan State University, MIT Software license; see doc/LICENSE.md
+ *  @date 2021.
+ *
+ *  @file  SkipSampler.hpp
+ *  @brief Jump directly between rare events at independent sites (e.g., per-site mutations).
+ *
+ *  When each site in a sequence has the same small probability p of an event, the number of
+ *  sites skipped before the next event is geometric, so it can be drawn with a single random
+ *  number rather than one per site:
+ *
+ *    for (size_t pos = sampler.NextSkip(random, N); pos < N;
+ *         pos += sampler.NextSkip(random, N) + 1) { ... }
+ *
+ *  Probabilities of zero (never any events) and one (every site) are handled exactly.
+ */
+
+#ifndef MABE_TOOL_SKIP_SAMPLER_H
+#define MABE_TOOL_SKIP_SAMPLER_H
+
+#include <cmath>
+#include <cstddef>
+
+#include "emp/math/Random.hpp"
+
+namespace mabe {
+
+  class SkipSampler {
+  private:
+    double prob = 0.0;      ///< Probability of an event at each site.
+    double log_keep = 0.0;  ///< Pre-calculated log(1 - prob), used when 0 < prob < 1.
+
+  public:
+    SkipSampler(double _prob=0.0) { SetProb(_prob); }
+
+    double GetProb() const { return prob; }
+
+    /// Set the per-site event probability (expected to be in [0.0, 1.0]).
+    void SetProb(double _prob) {
+      prob = _prob;
+      log_keep = (prob > 0.0 && prob < 1.0) ? std::log(1.0 - prob) : 0.0;
+    }
+
+    /// Number of sites to skip before the next event; returns max_skip if there would be no
+    /// event within the next max_skip sites.
+    size_t NextSkip(emp::Random & random, size_t max_skip) const {
+      if (prob <= 0.0) return max_skip;
+      if (prob >= 1.0) return 0;
+      const double skip = std::log(1.0 - random.GetDouble()) / log_keep;
+      return (skip < (double) max_skip) ? (size_t) skip : max_skip;
+    }
+  };
+
+}
+
+#endif
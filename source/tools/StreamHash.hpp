@@ -0,0 +1,60 @@
+/**
+ *  @note This file is part of MABE, https://github.com/mercere99/MABE2
+ *  @copyright Copyright (C) Michigan State University, MIT Software license; see doc/LICENSE.md
+ *  @date 2021.
+ *
+ *  @file  StreamHash.hpp
+ *  @brief Incremental 64-bit hashing of a sequence of values (e.g., a genome).
+ *
+ *  Values are fed in one at a time, so genomes stored in pieces hash the same as when stored
+ *  contiguously.  The hash is only meant for identifying identical sequences quickly; it is
+ *  not cryptographic.  MixBits() is also used directly where other tools need to scramble
+ *  64-bit values cheaply.
+ */
+
+#ifndef MABE_TOOL_STREAM_HASH_H
+#define MABE_TOOL_STREAM_HASH_H
+
+#include <cstdint>
+#include <cstring>
+
+namespace mabe {
+
+  /// Scramble the bits of a 64-bit value (the SplitMix64 finalizer).
+  inline uint64_t MixBits(uint64_t x) {
+    x ^= x >> 30;  x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;  x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+  }
+
+  class StreamHash {
+  private:
+    uint64_t state;
+
+  public:
+    StreamHash(uint64_t seed=0) : state(MixBits(seed + 0x9e3779b97f4a7c15ULL)) { }
+
+    /// Add the next value in the sequence.
+    StreamHash & Add(uint64_t value) {
+      state = MixBits(state ^ value) + 0x9e3779b97f4a7c15ULL;
+      return *this;
+    }
+
+    /// Add a double by its exact bit pattern.
+    StreamHash & AddDouble(double value) {
+      uint64_t bits;
+      std::memcpy(&bits, &value, sizeof(bits));
+      return Add(bits);
+    }
+
+    /// Get the hash of all values so far; never zero (so zero can mean "no hash").
+    uint64_t Get() const {
+      const uint64_t result = MixBits(state);
+      return result ? result : 1;
+    }
+  };
+
+}
+
+#endif